@@ -0,0 +1,20 @@
+#include "erosion_diagnostics.h"
+#include <algorithm>
+
+void ErosionDiagnostics::resize(uint32_t newWidth, uint32_t newHeight) {
+    if (newWidth == width && newHeight == height) {
+        return;
+    }
+    width = newWidth;
+    height = newHeight;
+    size_t cellCount = static_cast<size_t>(width) * height;
+    visits.assign(cellCount, 0);
+    eroded.assign(cellCount, 0.0f);
+    deposited.assign(cellCount, 0.0f);
+}
+
+void ErosionDiagnostics::clear() {
+    std::fill(visits.begin(), visits.end(), 0);
+    std::fill(eroded.begin(), eroded.end(), 0.0f);
+    std::fill(deposited.begin(), deposited.end(), 0.0f);
+}
@@ -0,0 +1,48 @@
+#ifndef EROSION_DIAGNOSTICS_H
+#define EROSION_DIAGNOSTICS_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// Per-cell maps of where erosion happened, row-major width * height. Values
+// accumulate over calls until clear(), so a whole animation can be summed.
+struct ErosionDiagnostics {
+    uint32_t width = 0;
+    uint32_t height = 0;
+    std::vector<uint32_t> visits;   // Droplet steps that started in the cell
+    std::vector<float> eroded;      // Material removed from the cell
+    std::vector<float> deposited;   // Material added to the cell
+
+    // Sizes the maps for a terrain, zeroing them if the size changed.
+    void resize(uint32_t newWidth, uint32_t newHeight);
+    void clear();
+};
+
+// Compile-time policies for the erosion kernels. A kernel templated on the
+// policy calls visit/erode/deposit as it goes; with NoDiagnostics every call
+// is empty and inlines away, so the kernel compiles to the same code as one
+// without the hooks.
+struct NoDiagnostics {
+    void visit(uint32_t, uint32_t) {}
+    void erode(uint32_t, uint32_t, float) {}
+    void deposit(uint32_t, uint32_t, float) {}
+};
+
+// Records into an ErosionDiagnostics that has already been sized.
+class CellDiagnostics {
+public:
+    explicit CellDiagnostics(ErosionDiagnostics& output) : m_output(output), m_width(output.width) {}
+
+    void visit(uint32_t x, uint32_t y) { m_output.visits[index(x, y)]++; }
+    void erode(uint32_t x, uint32_t y, float amount) { m_output.eroded[index(x, y)] += amount; }
+    void deposit(uint32_t x, uint32_t y, float amount) { m_output.deposited[index(x, y)] += amount; }
+
+private:
+    ErosionDiagnostics& m_output;
+    uint32_t m_width;
+
+    size_t index(uint32_t x, uint32_t y) const { return static_cast<size_t>(y) * m_width + x; }
+};
+
+#endif // EROSION_DIAGNOSTICS_H
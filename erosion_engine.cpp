@@ -0,0 +1,39 @@
+#include "erosion_engine.h"
+#include "erosion_diagnostics.h"
+#include <cmath>
+
+double ErosionEngine::erodeInPlace(std::vector<std::vector<float>>& heightMap, uint32_t iterations) {
+    std::vector<std::vector<float>> eroded = erode(heightMap, iterations);
+
+    double change = 0.0;
+    for (size_t y = 0; y < heightMap.size(); ++y) {
+        for (size_t x = 0; x < heightMap[y].size(); ++x) {
+            change += std::abs(eroded[y][x] - heightMap[y][x]);
+        }
+    }
+
+    heightMap = std::move(eroded);
+    return change;
+}
+
+double ErosionEngine::erodeWithDiagnostics(std::vector<std::vector<float>>& heightMap, uint32_t iterations, ErosionDiagnostics& diagnostics) {
+    uint32_t width = heightMap[0].size();
+    uint32_t height = heightMap.size();
+    diagnostics.resize(width, height);
+
+    std::vector<std::vector<float>> before = heightMap;
+    double change = erodeInPlace(heightMap, iterations);
+
+    CellDiagnostics record(diagnostics);
+    for (uint32_t y = 0; y < height; ++y) {
+        for (uint32_t x = 0; x < width; ++x) {
+            float delta = heightMap[y][x] - before[y][x];
+            if (delta > 0.0f) {
+                record.deposit(x, y, delta);
+            } else if (delta < 0.0f) {
+                record.erode(x, y, -delta);
+            }
+        }
+    }
+    return change;
+}
@@ -0,0 +1,35 @@
+#ifndef EROSION_ENGINE_H
+#define EROSION_ENGINE_H
+
+#include <vector>
+#include <cstdint>
+
+class MaterialLayers;
+struct ErosionDiagnostics;
+
+class ErosionEngine {
+public:
+    virtual ~ErosionEngine() = default;
+    virtual std::vector<std::vector<float>> erode(const std::vector<std::vector<float>>& heightMap, uint32_t iterations) = 0;
+
+    // Erodes heightMap in place and returns the net change of the call: the
+    // sum over all cells of |height after - height before|. Material moved
+    // away and back within one call does not count. The default goes through
+    // erode() and diffs the result; engines override it when they can track
+    // the change more cheaply.
+    virtual double erodeInPlace(std::vector<std::vector<float>>& heightMap, uint32_t iterations);
+    // Same as erodeInPlace for callers that don't need the change. The
+    // default forwards; engines whose change tracking costs something in the
+    // kernel override it to skip the bookkeeping.
+    virtual void erodeInPlaceUntracked(std::vector<std::vector<float>>& heightMap, uint32_t iterations) { erodeInPlace(heightMap, iterations); }
+    // Same as erodeInPlace, and adds to per-cell diagnostic maps. The default
+    // only knows the net change, which it books as eroded or deposited and
+    // leaves visits at zero; engines override it to record as they go.
+    virtual double erodeWithDiagnostics(std::vector<std::vector<float>>& heightMap, uint32_t iterations, ErosionDiagnostics& diagnostics);
+
+    // Non-owning; nullptr switches back to a single uniform material. Engines
+    // that don't model materials ignore it.
+    virtual void setMaterialLayers(MaterialLayers*) {}
+};
+
+#endif // EROSION_ENGINE_H
@@ -0,0 +1,243 @@
+#include "erosion_frame_codec.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <limits>
+#include <stdexcept>
+
+namespace {
+    const char kRecordingMagic[4] = {'E', 'R', 'E', 'C'};
+    const uint32_t kRecordingVersion = 1;
+
+    template <typename T>
+    void writeValue(std::ostream& stream, const T& value) {
+        stream.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    template <typename T>
+    void readValue(std::istream& stream, T& value) {
+        stream.read(reinterpret_cast<char*>(&value), sizeof(T));
+    }
+
+    void writeVarint(uint64_t value, std::vector<uint8_t>& out) {
+        while (value >= 0x80) {
+            out.push_back(static_cast<uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<uint8_t>(value));
+    }
+
+    uint64_t readVarint(const uint8_t*& data, const uint8_t* end) {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (data == end) {
+                throw std::runtime_error("Truncated erosion recording frame");
+            }
+            uint8_t byte = *data++;
+            value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0) {
+                return value;
+            }
+        }
+        throw std::runtime_error("Corrupt varint in erosion recording frame");
+    }
+
+    uint32_t zigzag(int32_t value) {
+        return (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31);
+    }
+
+    int32_t unzigzag(uint32_t value) {
+        return static_cast<int32_t>(value >> 1) ^ -static_cast<int32_t>(value & 1);
+    }
+
+    // Tokens: (run << 1) for a run of zero residuals, (zigzag << 1) | 1 for a literal.
+    void encodeTile(const std::vector<int32_t>& residuals, std::vector<uint8_t>& out) {
+        uint64_t run = 0;
+        for (int32_t residual : residuals) {
+            if (residual == 0) {
+                ++run;
+                continue;
+            }
+            if (run > 0) {
+                writeVarint(run << 1, out);
+                run = 0;
+            }
+            writeVarint((static_cast<uint64_t>(zigzag(residual)) << 1) | 1, out);
+        }
+        if (run > 0) {
+            writeVarint(run << 1, out);
+        }
+    }
+
+    void decodeTile(const uint8_t*& data, const uint8_t* end, std::vector<int32_t>& residuals) {
+        size_t filled = 0;
+        while (filled < residuals.size()) {
+            uint64_t token = readVarint(data, end);
+            if (token & 1) {
+                residuals[filled++] = unzigzag(static_cast<uint32_t>(token >> 1));
+            } else {
+                uint64_t run = token >> 1;
+                if (run == 0 || run > residuals.size() - filled) {
+                    throw std::runtime_error("Corrupt zero run in erosion recording frame");
+                }
+                std::fill_n(residuals.begin() + filled, run, 0);
+                filled += run;
+            }
+        }
+    }
+
+    struct TileRect {
+        uint32_t x0, y0, x1, y1;
+    };
+
+    template <typename Visit>
+    void forEachTile(const RecordingHeader& header, Visit visit) {
+        uint32_t tileIndex = 0;
+        for (uint32_t y0 = 0; y0 < header.height; y0 += header.tileSize) {
+            for (uint32_t x0 = 0; x0 < header.width; x0 += header.tileSize) {
+                TileRect rect{x0, y0, std::min(x0 + header.tileSize, header.width), std::min(y0 + header.tileSize, header.height)};
+                visit(tileIndex++, rect);
+            }
+        }
+    }
+
+    uint32_t tileCount(const RecordingHeader& header) {
+        uint32_t tilesX = (header.width + header.tileSize - 1) / header.tileSize;
+        uint32_t tilesY = (header.height + header.tileSize - 1) / header.tileSize;
+        return tilesX * tilesY;
+    }
+
+    // Keyframe prediction: left neighbour inside the tile, the cell above for
+    // the first column, zero for the tile origin.
+    int32_t predict(const std::vector<int32_t>& frame, uint32_t width, const TileRect& rect, uint32_t x, uint32_t y) {
+        if (x > rect.x0) {
+            return frame[y * width + x - 1];
+        }
+        if (y > rect.y0) {
+            return frame[(y - 1) * width + x];
+        }
+        return 0;
+    }
+}
+
+void ErosionFrameCodec::writeHeader(std::ostream& stream, const RecordingHeader& header) {
+    stream.write(kRecordingMagic, sizeof(kRecordingMagic));
+    writeValue(stream, kRecordingVersion);
+    writeValue(stream, header.width);
+    writeValue(stream, header.height);
+    writeValue(stream, header.tileSize);
+    writeValue(stream, header.keyframeInterval);
+    writeValue(stream, header.quantisationStep);
+}
+
+RecordingHeader ErosionFrameCodec::readHeader(std::istream& stream) {
+    char magic[4];
+    uint32_t version = 0;
+    stream.read(magic, sizeof(magic));
+    readValue(stream, version);
+    if (!stream || std::memcmp(magic, kRecordingMagic, sizeof(magic)) != 0 || version != kRecordingVersion) {
+        throw std::runtime_error("Not an erosion recording");
+    }
+
+    RecordingHeader header;
+    readValue(stream, header.width);
+    readValue(stream, header.height);
+    readValue(stream, header.tileSize);
+    readValue(stream, header.keyframeInterval);
+    readValue(stream, header.quantisationStep);
+    if (!stream || header.tileSize == 0 || header.keyframeInterval == 0 ||
+        !std::isfinite(header.quantisationStep) || header.quantisationStep <= 0.0f) {
+        throw std::runtime_error("Corrupt erosion recording header");
+    }
+    return header;
+}
+
+int32_t ErosionFrameCodec::quantise(float height, float step) {
+    double value = std::round(static_cast<double>(height) / step);
+    value = std::clamp(value, static_cast<double>(std::numeric_limits<int32_t>::min() / 2),
+                       static_cast<double>(std::numeric_limits<int32_t>::max() / 2));
+    return static_cast<int32_t>(value);
+}
+
+void ErosionFrameCodec::encodeKeyframe(const std::vector<int32_t>& frame, const RecordingHeader& header, std::vector<uint8_t>& out) {
+    std::vector<int32_t> residuals;
+    forEachTile(header, [&](uint32_t, const TileRect& rect) {
+        residuals.clear();
+        for (uint32_t y = rect.y0; y < rect.y1; ++y) {
+            for (uint32_t x = rect.x0; x < rect.x1; ++x) {
+                residuals.push_back(frame[y * header.width + x] - predict(frame, header.width, rect, x, y));
+            }
+        }
+        encodeTile(residuals, out);
+    });
+}
+
+void ErosionFrameCodec::encodeDelta(const std::vector<int32_t>& frame, const std::vector<int32_t>& previous,
+                                    const RecordingHeader& header, std::vector<uint8_t>& out) {
+    size_t bitmapOffset = out.size();
+    out.resize(out.size() + (tileCount(header) + 7) / 8, 0);
+
+    std::vector<int32_t> residuals;
+    forEachTile(header, [&](uint32_t tileIndex, const TileRect& rect) {
+        residuals.clear();
+        bool changed = false;
+        for (uint32_t y = rect.y0; y < rect.y1; ++y) {
+            for (uint32_t x = rect.x0; x < rect.x1; ++x) {
+                uint32_t index = y * header.width + x;
+                int32_t residual = frame[index] - previous[index];
+                changed |= residual != 0;
+                residuals.push_back(residual);
+            }
+        }
+        if (changed) {
+            out[bitmapOffset + tileIndex / 8] |= static_cast<uint8_t>(1u << (tileIndex % 8));
+            encodeTile(residuals, out);
+        }
+    });
+}
+
+void ErosionFrameCodec::decodeKeyframe(const uint8_t* data, size_t size, const RecordingHeader& header, std::vector<int32_t>& frame) {
+    const uint8_t* end = data + size;
+    frame.resize(static_cast<size_t>(header.width) * header.height);
+
+    std::vector<int32_t> residuals;
+    forEachTile(header, [&](uint32_t, const TileRect& rect) {
+        residuals.resize((rect.x1 - rect.x0) * (rect.y1 - rect.y0));
+        decodeTile(data, end, residuals);
+
+        size_t i = 0;
+        for (uint32_t y = rect.y0; y < rect.y1; ++y) {
+            for (uint32_t x = rect.x0; x < rect.x1; ++x) {
+                frame[y * header.width + x] = residuals[i++] + predict(frame, header.width, rect, x, y);
+            }
+        }
+    });
+}
+
+void ErosionFrameCodec::decodeDelta(const uint8_t* data, size_t size, const RecordingHeader& header, std::vector<int32_t>& frame) {
+    const uint8_t* end = data + size;
+    size_t bitmapSize = (tileCount(header) + 7) / 8;
+    if (size < bitmapSize) {
+        throw std::runtime_error("Truncated erosion recording frame");
+    }
+    const uint8_t* bitmap = data;
+    data += bitmapSize;
+
+    std::vector<int32_t> residuals;
+    forEachTile(header, [&](uint32_t tileIndex, const TileRect& rect) {
+        if ((bitmap[tileIndex / 8] & (1u << (tileIndex % 8))) == 0) {
+            return;
+        }
+        residuals.resize((rect.x1 - rect.x0) * (rect.y1 - rect.y0));
+        decodeTile(data, end, residuals);
+
+        size_t i = 0;
+        for (uint32_t y = rect.y0; y < rect.y1; ++y) {
+            for (uint32_t x = rect.x0; x < rect.x1; ++x) {
+                frame[y * header.width + x] += residuals[i++];
+            }
+        }
+    });
+}
@@ -0,0 +1,43 @@
+#ifndef EROSION_FRAME_CODEC_H
+#define EROSION_FRAME_CODEC_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <iosfwd>
+
+struct RecordingHeader {
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t tileSize = 16;
+    uint32_t keyframeInterval = 30;
+    float quantisationStep = 1.0f / 65535.0f;
+};
+
+// Encodes quantised height frames tile by tile. Each tile is a stream of
+// varint tokens: a zero-run length, or one zigzag-coded residual. Keyframes
+// store every tile with residuals against the left (or upper) neighbour.
+// Delta frames start with a bitmap of changed tiles and only store those
+// tiles, with residuals against the previous frame.
+class ErosionFrameCodec {
+public:
+    enum FrameType : uint8_t { Keyframe = 0, DeltaFrame = 1 };
+
+    static void encodeKeyframe(const std::vector<int32_t>& frame, const RecordingHeader& header, std::vector<uint8_t>& out);
+    static void encodeDelta(const std::vector<int32_t>& frame, const std::vector<int32_t>& previous,
+                            const RecordingHeader& header, std::vector<uint8_t>& out);
+
+    // Both decoders throw std::runtime_error on truncated or corrupt input.
+    static void decodeKeyframe(const uint8_t* data, size_t size, const RecordingHeader& header, std::vector<int32_t>& frame);
+    // Applies the delta on top of frame, which must hold the previous frame.
+    static void decodeDelta(const uint8_t* data, size_t size, const RecordingHeader& header, std::vector<int32_t>& frame);
+
+    static void writeHeader(std::ostream& stream, const RecordingHeader& header);
+    // Throws std::runtime_error if the stream is not an erosion recording.
+    static RecordingHeader readHeader(std::istream& stream);
+
+    static int32_t quantise(float height, float step);
+    static float dequantise(int32_t value, float step) { return value * step; }
+};
+
+#endif // EROSION_FRAME_CODEC_H
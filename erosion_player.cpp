@@ -0,0 +1,103 @@
+#include "erosion_player.h"
+#include <algorithm>
+#include <stdexcept>
+
+ErosionPlayer::ErosionPlayer(const std::string& path)
+    : m_file(path, std::ios::binary), m_decoded(-1), m_position(0) {
+    if (!m_file) {
+        throw std::runtime_error("Could not open " + path + " for reading");
+    }
+
+    m_header = ErosionFrameCodec::readHeader(m_file);
+    readIndex();
+}
+
+void ErosionPlayer::readIndex() {
+    std::streamoff position = m_file.tellg();
+    m_file.seekg(0, std::ios::end);
+    std::streamoff fileSize = m_file.tellg();
+    m_file.seekg(position);
+
+    // Only the per-frame headers are read here; payloads are loaded on demand
+    const std::streamoff frameHeaderSize = sizeof(uint8_t) + sizeof(uint32_t);
+    while (position + frameHeaderSize <= fileSize) {
+        uint8_t type;
+        uint32_t size;
+        m_file.read(reinterpret_cast<char*>(&type), sizeof(type));
+        m_file.read(reinterpret_cast<char*>(&size), sizeof(size));
+        position += frameHeaderSize;
+        if (!m_file || position + size > fileSize) {
+            break; // Truncated trailing frame, e.g. the recorder was killed
+        }
+        if (m_frames.empty() && type != ErosionFrameCodec::Keyframe) {
+            throw std::runtime_error("Erosion recording does not start with a keyframe");
+        }
+
+        m_frames.push_back({position, size, type});
+        position += size;
+        m_file.seekg(position);
+    }
+    m_file.clear();
+}
+
+void ErosionPlayer::seek(uint32_t frame) {
+    m_position = std::min(frame, getFrameCount());
+}
+
+bool ErosionPlayer::advance(Terrain& terrain, uint32_t frames) {
+    if (m_position >= getFrameCount()) {
+        return false;
+    }
+    if (terrain.getWidth() != m_header.width || terrain.getHeight() != m_header.height) {
+        throw std::invalid_argument("Terrain size does not match the recording");
+    }
+
+    uint32_t target = m_position;
+    decodeTo(target);
+    m_position = target + std::max(frames, 1u);
+
+    for (uint32_t y = 0; y < m_header.height; ++y) {
+        for (uint32_t x = 0; x < m_header.width; ++x) {
+            terrain.setHeight(x, y, ErosionFrameCodec::dequantise(m_current[y * m_header.width + x], m_header.quantisationStep));
+        }
+    }
+    return true;
+}
+
+void ErosionPlayer::decodeTo(uint32_t frame) {
+    // Nearest keyframe at or before the target
+    uint32_t keyframe = frame;
+    while (m_frames[keyframe].type != ErosionFrameCodec::Keyframe) {
+        --keyframe;
+    }
+
+    // Rolling forward from the current frame is cheaper than restarting only
+    // if no keyframe lies in between
+    uint32_t start;
+    if (m_decoded >= static_cast<int64_t>(keyframe) && m_decoded <= static_cast<int64_t>(frame)) {
+        start = static_cast<uint32_t>(m_decoded) + 1;
+    } else {
+        start = keyframe;
+    }
+
+    for (uint32_t i = start; i <= frame; ++i) {
+        decodeFrame(i);
+    }
+}
+
+void ErosionPlayer::decodeFrame(uint32_t frame) {
+    const FrameEntry& entry = m_frames[frame];
+    m_payload.resize(entry.size);
+    m_file.seekg(entry.offset);
+    m_file.read(reinterpret_cast<char*>(m_payload.data()), entry.size);
+    if (!m_file) {
+        throw std::runtime_error("Failed reading erosion recording frame");
+    }
+
+    if (entry.type == ErosionFrameCodec::Keyframe) {
+        ErosionFrameCodec::decodeKeyframe(m_payload.data(), m_payload.size(), m_header, m_current);
+    } else {
+        ErosionFrameCodec::decodeDelta(m_payload.data(), m_payload.size(), m_header, m_current);
+    }
+    m_decoded = frame;
+}
@@ -0,0 +1,54 @@
+#ifndef EROSION_PLAYER_H
+#define EROSION_PLAYER_H
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "terrain.h"
+#include "erosion_frame_codec.h"
+
+// Plays back a file written by ErosionRecorder. Only decoding is done, no
+// simulation. Seeking restarts from the nearest keyframe at or before the
+// target, so its cost is bounded by the keyframe interval.
+//
+// advance() fits the erodeStep callback of the visualizers, so a recording
+// can be replayed at any speed through animateErosion:
+//   visualizer.animateErosion(terrain, [&](Terrain& t) { player.advance(t, 4); }, player.getFrameCount() / 4, fps);
+class ErosionPlayer {
+public:
+    explicit ErosionPlayer(const std::string& path);
+
+    uint32_t getWidth() const { return m_header.width; }
+    uint32_t getHeight() const { return m_header.height; }
+    uint32_t getFrameCount() const { return static_cast<uint32_t>(m_frames.size()); }
+    // Index of the next frame advance() will produce.
+    uint32_t getPosition() const { return m_position; }
+
+    void seek(uint32_t frame);
+    // Moves forward by `frames` (1 = normal speed) and writes the resulting
+    // frame into terrain. Returns false, leaving terrain untouched, once the
+    // end has been reached.
+    bool advance(Terrain& terrain, uint32_t frames = 1);
+
+private:
+    struct FrameEntry {
+        std::streamoff offset;
+        uint32_t size;
+        uint8_t type;
+    };
+
+    std::ifstream m_file;
+    RecordingHeader m_header;
+    std::vector<FrameEntry> m_frames;
+    std::vector<int32_t> m_current;
+    std::vector<uint8_t> m_payload;
+    int64_t m_decoded;      // Frame held in m_current, -1 if none
+    uint32_t m_position;
+
+    void readIndex();
+    void decodeTo(uint32_t frame);
+    void decodeFrame(uint32_t frame);
+};
+
+#endif // EROSION_PLAYER_H
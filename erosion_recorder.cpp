@@ -0,0 +1,155 @@
+#include "erosion_recorder.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace {
+    template <typename T>
+    void writeValue(std::ofstream& file, const T& value) {
+        file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+}
+
+ErosionRecorder::ErosionRecorder(const std::string& path, uint32_t width, uint32_t height, uint32_t keyframeInterval,
+                                 float quantisationStep, uint32_t tileSize, uint32_t maxQueuedFrames)
+    : m_file(path, std::ios::binary), m_maxQueuedFrames(std::max(maxQueuedFrames, 1u)), m_capturedFrames(0), m_finishing(false) {
+    if (!std::isfinite(quantisationStep) || quantisationStep <= 0.0f) {
+        throw std::invalid_argument("Quantisation step must be positive and finite");
+    }
+    if (!m_file) {
+        throw std::runtime_error("Could not open " + path + " for writing");
+    }
+
+    m_header.width = width;
+    m_header.height = height;
+    m_header.tileSize = std::max(tileSize, 1u);
+    m_header.keyframeInterval = std::max(keyframeInterval, 1u);
+    m_header.quantisationStep = quantisationStep;
+
+    ErosionFrameCodec::writeHeader(m_file, m_header);
+
+    m_encoder = std::thread(&ErosionRecorder::encoderLoop, this);
+}
+
+ErosionRecorder::~ErosionRecorder() {
+    try {
+        finish();
+    } catch (...) {
+        // Destructors must not throw; call finish() directly to see the error
+    }
+}
+
+void ErosionRecorder::capture(const Terrain& terrain) {
+    if (terrain.getWidth() != m_header.width || terrain.getHeight() != m_header.height) {
+        throw std::invalid_argument("Terrain size does not match the recording");
+    }
+
+    std::vector<float> snapshot;
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (!m_error.empty()) {
+            throw std::runtime_error(m_error);
+        }
+        if (m_finishing) {
+            throw std::logic_error("capture() called after finish()");
+        }
+        m_queueChanged.wait(lock, [this] { return m_queue.size() < m_maxQueuedFrames; });
+        if (!m_freeBuffers.empty()) {
+            snapshot = std::move(m_freeBuffers.back());
+            m_freeBuffers.pop_back();
+        }
+    }
+
+    snapshot.resize(static_cast<size_t>(m_header.width) * m_header.height);
+    for (uint32_t y = 0; y < m_header.height; ++y) {
+        for (uint32_t x = 0; x < m_header.width; ++x) {
+            snapshot[y * m_header.width + x] = terrain.getHeight(x, y);
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_queue.push_back(std::move(snapshot));
+        ++m_capturedFrames;
+    }
+    m_queueChanged.notify_all();
+}
+
+void ErosionRecorder::finish() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_finishing = true;
+    }
+    m_queueChanged.notify_all();
+
+    if (m_encoder.joinable()) {
+        m_encoder.join();
+        m_file.flush();
+        if (!m_file && m_error.empty()) {
+            m_error = "Failed writing erosion recording";
+        }
+    }
+
+    if (!m_error.empty()) {
+        throw std::runtime_error(m_error);
+    }
+}
+
+void ErosionRecorder::encoderLoop() {
+    std::vector<int32_t> frame(static_cast<size_t>(m_header.width) * m_header.height);
+    std::vector<int32_t> previous;
+    std::vector<uint8_t> payload;
+    uint32_t frameIndex = 0;
+
+    while (true) {
+        std::vector<float> snapshot;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_queueChanged.wait(lock, [this] { return m_finishing || !m_queue.empty(); });
+            if (m_queue.empty()) {
+                return;
+            }
+            snapshot = std::move(m_queue.front());
+            m_queue.pop_front();
+        }
+        m_queueChanged.notify_all();
+
+        for (size_t i = 0; i < snapshot.size(); ++i) {
+            frame[i] = ErosionFrameCodec::quantise(snapshot[i], m_header.quantisationStep);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_freeBuffers.push_back(std::move(snapshot));
+        }
+
+        // Deltas are taken against the previous quantised frame, so
+        // quantisation error never accumulates during playback.
+        payload.clear();
+        uint8_t type;
+        if (frameIndex % m_header.keyframeInterval == 0) {
+            type = ErosionFrameCodec::Keyframe;
+            ErosionFrameCodec::encodeKeyframe(frame, m_header, payload);
+        } else {
+            type = ErosionFrameCodec::DeltaFrame;
+            ErosionFrameCodec::encodeDelta(frame, previous, m_header, payload);
+        }
+
+        uint32_t payloadSize = static_cast<uint32_t>(payload.size());
+        writeValue(m_file, type);
+        writeValue(m_file, payloadSize);
+        m_file.write(reinterpret_cast<const char*>(payload.data()), payload.size());
+        if (!m_file) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_error = "Failed writing erosion recording";
+            m_queue.clear();
+            m_finishing = true;
+            m_queueChanged.notify_all();
+            return;
+        }
+
+        previous.swap(frame);
+        frame.resize(previous.size());
+        ++frameIndex;
+    }
+}
@@ -0,0 +1,51 @@
+#ifndef EROSION_RECORDER_H
+#define EROSION_RECORDER_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "terrain.h"
+#include "erosion_frame_codec.h"
+
+// Records a Terrain after each erosion step into a delta-compressed file that
+// ErosionPlayer can replay without re-simulating. capture() only copies the
+// heights; quantisation, encoding and disk writes run on a background thread.
+class ErosionRecorder {
+public:
+    ErosionRecorder(const std::string& path, uint32_t width, uint32_t height, uint32_t keyframeInterval = 30,
+                    float quantisationStep = 1.0f / 65535.0f, uint32_t tileSize = 16, uint32_t maxQueuedFrames = 8);
+    ~ErosionRecorder();
+
+    ErosionRecorder(const ErosionRecorder&) = delete;
+    ErosionRecorder& operator=(const ErosionRecorder&) = delete;
+
+    // Blocks only if the encoder is maxQueuedFrames behind.
+    void capture(const Terrain& terrain);
+    // Drains the queue and flushes the file. Rethrows encoder errors.
+    void finish();
+
+    uint32_t getCapturedFrames() const { return m_capturedFrames; }
+
+private:
+    RecordingHeader m_header;
+    std::ofstream m_file;
+    uint32_t m_maxQueuedFrames;
+    uint32_t m_capturedFrames;
+
+    std::deque<std::vector<float>> m_queue;
+    std::vector<std::vector<float>> m_freeBuffers;
+    std::mutex m_mutex;
+    std::condition_variable m_queueChanged;
+    bool m_finishing;
+    std::string m_error;
+    std::thread m_encoder;
+
+    void encoderLoop();
+};
+
+#endif // EROSION_RECORDER_H
@@ -0,0 +1,55 @@
+#include "erosion_schedule.h"
+#include <cmath>
+
+void ErosionSchedule::addStage(std::unique_ptr<ErosionEngine> engine, uint32_t iterationsPerRound) {
+    m_stages.push_back({std::move(engine), iterationsPerRound});
+}
+
+std::vector<std::vector<float>> ErosionSchedule::erode(const std::vector<std::vector<float>>& inputHeightMap, uint32_t rounds) {
+    std::vector<std::vector<float>> heightMap = inputHeightMap;
+    erodeInPlaceUntracked(heightMap, rounds);
+    return heightMap;
+}
+
+// Stages can undo each other's work, so the net change is measured against
+// a snapshot rather than summed over stages, and the stages themselves run
+// untracked.
+double ErosionSchedule::erodeInPlace(std::vector<std::vector<float>>& heightMap, uint32_t rounds) {
+    std::vector<std::vector<float>> before = heightMap;
+    erodeInPlaceUntracked(heightMap, rounds);
+    return netChange(before, heightMap);
+}
+
+void ErosionSchedule::erodeInPlaceUntracked(std::vector<std::vector<float>>& heightMap, uint32_t rounds) {
+    for (uint32_t round = 0; round < rounds; ++round) {
+        for (Stage& stage : m_stages) {
+            stage.engine->erodeInPlaceUntracked(heightMap, stage.iterationsPerRound);
+        }
+    }
+}
+
+double ErosionSchedule::erodeWithDiagnostics(std::vector<std::vector<float>>& heightMap, uint32_t rounds, ErosionDiagnostics& diagnostics) {
+    std::vector<std::vector<float>> before = heightMap;
+    for (uint32_t round = 0; round < rounds; ++round) {
+        for (Stage& stage : m_stages) {
+            stage.engine->erodeWithDiagnostics(heightMap, stage.iterationsPerRound, diagnostics);
+        }
+    }
+    return netChange(before, heightMap);
+}
+
+double ErosionSchedule::netChange(const std::vector<std::vector<float>>& before, const std::vector<std::vector<float>>& after) {
+    double change = 0.0;
+    for (size_t y = 0; y < after.size(); ++y) {
+        for (size_t x = 0; x < after[y].size(); ++x) {
+            change += std::abs(after[y][x] - before[y][x]);
+        }
+    }
+    return change;
+}
+
+void ErosionSchedule::setMaterialLayers(MaterialLayers* layers) {
+    for (Stage& stage : m_stages) {
+        stage.engine->setMaterialLayers(layers);
+    }
+}
@@ -0,0 +1,35 @@
+#ifndef EROSION_SCHEDULE_H
+#define EROSION_SCHEDULE_H
+
+#include <vector>
+#include <cstdint>
+#include <memory>
+#include "erosion_engine.h"
+
+// Interleaves several erosion engines. One iteration of the schedule is one
+// round: every stage runs its own number of iterations, in the order the
+// stages were added. E.g. 2000 droplets followed by 5 thermal sweeps per round.
+class ErosionSchedule : public ErosionEngine {
+public:
+    void addStage(std::unique_ptr<ErosionEngine> engine, uint32_t iterationsPerRound);
+
+    std::vector<std::vector<float>> erode(const std::vector<std::vector<float>>& heightMap, uint32_t rounds) override;
+    double erodeInPlace(std::vector<std::vector<float>>& heightMap, uint32_t rounds) override;
+    // Runs every stage untracked and skips the snapshot.
+    void erodeInPlaceUntracked(std::vector<std::vector<float>>& heightMap, uint32_t rounds) override;
+    // Every stage adds to the same maps.
+    double erodeWithDiagnostics(std::vector<std::vector<float>>& heightMap, uint32_t rounds, ErosionDiagnostics& diagnostics) override;
+    void setMaterialLayers(MaterialLayers* layers) override;
+
+private:
+    struct Stage {
+        std::unique_ptr<ErosionEngine> engine;
+        uint32_t iterationsPerRound;
+    };
+
+    std::vector<Stage> m_stages;
+
+    static double netChange(const std::vector<std::vector<float>>& before, const std::vector<std::vector<float>>& after);
+};
+
+#endif // EROSION_SCHEDULE_H
@@ -1,27 +1,259 @@
 #include "erosion_simulator.h"
 #include <cmath>
 #include <algorithm>
+#include <stdexcept>
 
-ErosionSimulator::ErosionSimulator(uint32_t seed) : m_rng(seed) {}
+namespace {
+    // Change-tracking policies for the height field adapters, chosen at
+    // compile time like the diagnostics policies. NoChangeTracking never sees
+    // a first write, so the adapters compile to plain reads and writes.
+    struct NoChangeTracking {
+        bool firstWrite(size_t) { return false; }
+        void remember(size_t, float) {}
+        template <typename HeightAt>
+        double take(HeightAt) { return 0.0; }
+    };
+
+    // Remembers the height each cell of a dense block had before its first
+    // write, so a batch can report its net per-cell change without diffing
+    // the whole block. The flags and the list belong to the simulator and are
+    // reused between batches.
+    class NetChangeTracking {
+    public:
+        NetChangeTracking(std::vector<uint8_t>& touched, std::vector<std::pair<size_t, float>>& originals, size_t cellCount)
+            : m_touched(touched), m_originals(originals) {
+            if (m_touched.size() < cellCount) {
+                m_touched.resize(cellCount, 0);
+            }
+        }
+
+        bool firstWrite(size_t index) {
+            if (m_touched[index]) {
+                return false;
+            }
+            m_touched[index] = 1;
+            return true;
+        }
+        void remember(size_t index, float height) { m_originals.push_back({index, height}); }
+
+        // Sum of |h - original| over the written cells; starts a new batch.
+        template <typename HeightAt>
+        double take(HeightAt heightAt) {
+            double change = 0.0;
+            for (const auto& [index, original] : m_originals) {
+                change += std::abs(heightAt(index) - original);
+                m_touched[index] = 0;
+            }
+            m_originals.clear();
+            return change;
+        }
+
+    private:
+        std::vector<uint8_t>& m_touched;
+        std::vector<std::pair<size_t, float>>& m_originals;
+    };
+
+    // Gives a nested height map the same sampling API as Terrain.
+    template <typename Tracking>
+    class NestedHeightMap {
+    public:
+        NestedHeightMap(std::vector<std::vector<float>>& heightMap, Tracking& tracking)
+            : m_heightMap(heightMap), m_width(heightMap[0].size()), m_tracking(tracking) {}
+
+        uint32_t getWidth() const { return m_width; }
+        uint32_t getHeight() const { return m_heightMap.size(); }
+        float getHeight(uint32_t x, uint32_t y) const { return m_heightMap[y][x]; }
+        void setHeight(uint32_t x, uint32_t y, float height) {
+            size_t index = static_cast<size_t>(y) * m_width + x;
+            if (m_tracking.firstWrite(index)) {
+                m_tracking.remember(index, m_heightMap[y][x]);
+            }
+            m_heightMap[y][x] = height;
+        }
+
+        double takeNetChange() {
+            return m_tracking.take([this](size_t index) { return m_heightMap[index / m_width][index % m_width]; });
+        }
+
+    private:
+        std::vector<std::vector<float>>& m_heightMap;
+        uint32_t m_width;
+        Tracking& m_tracking;
+    };
+
+    // Same bookkeeping for a TiledHeightStore, which may be far larger than
+    // memory. Each tile written in the current batch gets a dense block of
+    // flags and its own list of originals, recycled for the next batch, so
+    // the net change is summed one tile at a time straight from its cells.
+    class TrackedTiledStore {
+    public:
+        explicit TrackedTiledStore(TiledHeightStore& store)
+            : m_store(store), m_tileShift(0), m_tileMask(store.getTileSize() - 1),
+              m_blockOfTile(static_cast<size_t>(store.getTilesX()) * store.getTilesY(), kNoBlock) {
+            while ((1u << m_tileShift) < store.getTileSize()) {
+                ++m_tileShift;
+            }
+        }
+
+        uint32_t getWidth() const { return m_store.getWidth(); }
+        uint32_t getHeight() const { return m_store.getHeight(); }
+        float getHeight(uint32_t x, uint32_t y) const { return m_store.getHeight(x, y); }
+        void setHeight(uint32_t x, uint32_t y, float height) {
+            Block& block = blockOf(x, y);
+            uint32_t cell = ((y & m_tileMask) << m_tileShift) + (x & m_tileMask);
+            if (!block.touched[cell]) {
+                block.touched[cell] = 1;
+                block.originals.push_back({cell, m_store.getHeight(x, y)});
+            }
+            m_store.setHeight(x, y, height);
+        }
+
+        // Sum of |h - original| over the written cells; starts a new batch.
+        double takeNetChange() {
+            double change = 0.0;
+            for (size_t i = 0; i < m_usedTiles.size(); ++i) {
+                uint32_t tile = m_usedTiles[i];
+                uint32_t tileX = tile % m_store.getTilesX();
+                uint32_t tileY = tile / m_store.getTilesX();
+                Block& block = m_blocks[i];
+
+                const float* cells = m_store.pinTile(tileX, tileY);
+                for (const auto& [cell, original] : block.originals) {
+                    change += std::abs(cells[cell] - original);
+                    block.touched[cell] = 0;
+                }
+                m_store.unpinTile(tileX, tileY);
+
+                block.originals.clear();
+                m_blockOfTile[tile] = kNoBlock;
+            }
+            m_usedTiles.clear();
+            return change;
+        }
+
+    private:
+        struct Block {
+            std::vector<uint8_t> touched;                       // All zero between batches
+            std::vector<std::pair<uint32_t, float>> originals;  // Cell within the tile, height before
+        };
+        static constexpr uint32_t kNoBlock = ~0u;
+
+        TiledHeightStore& m_store;
+        uint32_t m_tileShift;
+        uint32_t m_tileMask;
+        std::vector<uint32_t> m_blockOfTile;
+        std::vector<Block> m_blocks;
+        std::vector<uint32_t> m_usedTiles;      // Tile of m_blocks[i]
+
+        Block& blockOf(uint32_t x, uint32_t y) {
+            uint32_t tile = (y >> m_tileShift) * m_store.getTilesX() + (x >> m_tileShift);
+            uint32_t block = m_blockOfTile[tile];
+            if (block == kNoBlock) {
+                block = m_usedTiles.size();
+                if (block == m_blocks.size()) {
+                    m_blocks.push_back({std::vector<uint8_t>(static_cast<size_t>(m_tileMask + 1) * (m_tileMask + 1), 0), {}});
+                }
+                m_blockOfTile[tile] = block;
+                m_usedTiles.push_back(tile);
+            }
+            return m_blocks[block];
+        }
+    };
+}
+
+ErosionSimulator::ErosionSimulator(uint32_t seed) : m_rng(seed), m_layers(nullptr) {}
 
 std::vector<std::vector<float>> ErosionSimulator::erode(const std::vector<std::vector<float>>& inputHeightMap, uint32_t iterations) {
     std::vector<std::vector<float>> heightMap = inputHeightMap; // Create a copy to work on
+    erodeInPlaceUntracked(heightMap, iterations);
+    return heightMap;
+}
+
+double ErosionSimulator::erodeInPlace(std::vector<std::vector<float>>& heightMap, uint32_t iterations) {
+    NoDiagnostics diagnostics;
+    NetChangeTracking tracking(m_touched, m_originals, static_cast<size_t>(heightMap[0].size()) * heightMap.size());
+    return erodeDroplets(heightMap, iterations, tracking, diagnostics);
+}
+
+void ErosionSimulator::erodeInPlaceUntracked(std::vector<std::vector<float>>& heightMap, uint32_t iterations) {
+    NoDiagnostics diagnostics;
+    NoChangeTracking tracking;
+    erodeDroplets(heightMap, iterations, tracking, diagnostics);
+}
+
+double ErosionSimulator::erodeWithDiagnostics(std::vector<std::vector<float>>& heightMap, uint32_t iterations, ErosionDiagnostics& diagnostics) {
+    diagnostics.resize(heightMap[0].size(), heightMap.size());
+    CellDiagnostics record(diagnostics);
+    NetChangeTracking tracking(m_touched, m_originals, static_cast<size_t>(heightMap[0].size()) * heightMap.size());
+    return erodeDroplets(heightMap, iterations, tracking, record);
+}
+
+template <typename Tracking, typename Diagnostics>
+double ErosionSimulator::erodeDroplets(std::vector<std::vector<float>>& heightMap, uint32_t iterations, Tracking& tracking, Diagnostics& diagnostics) {
     uint32_t width = heightMap[0].size();
     uint32_t height = heightMap.size();
 
     std::uniform_int_distribution<uint32_t> xDist(0, width - 1);
     std::uniform_int_distribution<uint32_t> yDist(0, height - 1);
 
+    NestedHeightMap<Tracking> heightField(heightMap, tracking);
     for (uint32_t i = 0; i < iterations; ++i) {
         uint32_t x = xDist(m_rng);
         uint32_t y = yDist(m_rng);
-        erodePoint(heightMap, x, y);
+        erodePoint(heightField, x, y, diagnostics);
     }
 
-    return heightMap;
+    return heightField.takeNetChange();
 }
 
-void ErosionSimulator::erodePoint(std::vector<std::vector<float>>& heightMap, uint32_t x, uint32_t y) {
+double ErosionSimulator::erodeTiled(TiledHeightStore& store, uint32_t dropletsPerTile) {
+    if (m_layers) {
+        throw std::runtime_error("Material layers are not supported on tiled terrain");
+    }
+
+    uint32_t tileSize = store.getTileSize();
+    uint32_t tilesX = store.getTilesX();
+    uint32_t tilesY = store.getTilesY();
+
+    NoDiagnostics diagnostics;
+    TrackedTiledStore heightField(store);
+    double change = 0.0;
+    for (uint32_t tileY = 0; tileY < tilesY; ++tileY) {
+        for (uint32_t tileX = 0; tileX < tilesX; ++tileX) {
+            uint32_t nx0 = tileX > 0 ? tileX - 1 : 0;
+            uint32_t ny0 = tileY > 0 ? tileY - 1 : 0;
+            uint32_t nx1 = std::min(tileX + 1, tilesX - 1);
+            uint32_t ny1 = std::min(tileY + 1, tilesY - 1);
+            for (uint32_t ny = ny0; ny <= ny1; ++ny) {
+                for (uint32_t nx = nx0; nx <= nx1; ++nx) {
+                    store.pinTile(nx, ny);
+                }
+            }
+
+            uint32_t x0 = tileX * tileSize;
+            uint32_t y0 = tileY * tileSize;
+            std::uniform_int_distribution<uint32_t> xDist(x0, std::min(x0 + tileSize, store.getWidth()) - 1);
+            std::uniform_int_distribution<uint32_t> yDist(y0, std::min(y0 + tileSize, store.getHeight()) - 1);
+            for (uint32_t i = 0; i < dropletsPerTile; ++i) {
+                uint32_t x = xDist(m_rng);
+                uint32_t y = yDist(m_rng);
+                erodePoint(heightField, x, y, diagnostics);
+            }
+            change += heightField.takeNetChange();
+
+            for (uint32_t ny = ny0; ny <= ny1; ++ny) {
+                for (uint32_t nx = nx0; nx <= nx1; ++nx) {
+                    store.unpinTile(nx, ny);
+                }
+            }
+        }
+    }
+
+    return change;
+}
+
+template <typename HeightField, typename Diagnostics>
+void ErosionSimulator::erodePoint(HeightField& heightField, uint32_t x, uint32_t y, Diagnostics& diagnostics) {
     const float inertia = 0.05f;
     const float minSlope = 0.01f;
     const float capacity = 4.0f;
@@ -36,8 +268,8 @@ void ErosionSimulator::erodePoint(std::vector<std::vector<float>>& heightMap, ui
     float water = 1.0f;
     float sediment = 0.0f;
 
-    uint32_t width = heightMap[0].size();
-    uint32_t height = heightMap.size();
+    uint32_t width = heightField.getWidth();
+    uint32_t height = heightField.getHeight();
 
     while (water > 0.01f) {
         int cellX = static_cast<int>(posX);
@@ -47,10 +279,11 @@ void ErosionSimulator::erodePoint(std::vector<std::vector<float>>& heightMap, ui
         if (cellX < 0 || cellX >= static_cast<int>(width) - 1 || cellY < 0 || cellY >= static_cast<int>(height) - 1) {
             break;
         }
+        diagnostics.visit(cellX, cellY);
 
         // Calculate gradient
-        float gradX = (getInterpolatedHeight(heightMap, posX + 1, posY) - getInterpolatedHeight(heightMap, posX - 1, posY)) * 0.5f;
-        float gradY = (getInterpolatedHeight(heightMap, posX, posY + 1) - getInterpolatedHeight(heightMap, posX, posY - 1)) * 0.5f;
+        float gradX = (getInterpolatedHeight(heightField, posX + 1, posY) - getInterpolatedHeight(heightField, posX - 1, posY)) * 0.5f;
+        float gradY = (getInterpolatedHeight(heightField, posX, posY + 1) - getInterpolatedHeight(heightField, posX, posY - 1)) * 0.5f;
 
         // Update direction
         dirX = (dirX * inertia - gradX * (1 - inertia));
@@ -73,20 +306,30 @@ void ErosionSimulator::erodePoint(std::vector<std::vector<float>>& heightMap, ui
         }
 
         // Calculate height difference
-        float newHeight = getInterpolatedHeight(heightMap, posX, posY);
-        float deltaHeight = newHeight - heightMap[cellY][cellX];
+        float newHeight = getInterpolatedHeight(heightField, posX, posY);
+        float deltaHeight = newHeight - heightField.getHeight(cellX, cellY);
 
         // Deposit or erode
         if (deltaHeight > 0 || speed < minSlope) {
             if (sediment > 0) {
                 float amountToDeposit = std::min(deltaHeight, sediment);
                 sediment -= amountToDeposit;
-                heightMap[cellY][cellX] += amountToDeposit * deposition;
+                heightField.setHeight(cellX, cellY, heightField.getHeight(cellX, cellY) + amountToDeposit * deposition);
+                diagnostics.deposit(cellX, cellY, amountToDeposit * deposition);
+                if (m_layers) {
+                    m_layers->deposit(cellX, cellY, amountToDeposit * deposition);
+                }
             }
         } else {
             float amountToErode = std::min(-deltaHeight, capacity * speed - sediment) * erosion;
-            heightMap[cellY][cellX] -= amountToErode;
+            if (m_layers) {
+                // Hardness of whatever is exposed at this cell
+                amountToErode *= m_layers->getErodibility(cellX, cellY);
+                m_layers->erode(cellX, cellY, amountToErode);
+            }
+            heightField.setHeight(cellX, cellY, heightField.getHeight(cellX, cellY) - amountToErode);
             sediment += amountToErode;
+            diagnostics.erode(cellX, cellY, amountToErode);
         }
 
         // Update speed and water
@@ -95,15 +338,16 @@ void ErosionSimulator::erodePoint(std::vector<std::vector<float>>& heightMap, ui
     }
 }
 
-float ErosionSimulator::getInterpolatedHeight(const std::vector<std::vector<float>>& heightMap, float x, float y) {
+template <typename HeightField>
+float ErosionSimulator::getInterpolatedHeight(const HeightField& heightField, float x, float y) {
     int x0 = static_cast<int>(std::floor(x));
     int x1 = x0 + 1;
     int y0 = static_cast<int>(std::floor(y));
     int y1 = y0 + 1;
 
     // Ensure we're within bounds
-    uint32_t width = heightMap[0].size();
-    uint32_t height = heightMap.size();
+    uint32_t width = heightField.getWidth();
+    uint32_t height = heightField.getHeight();
     x0 = std::clamp(x0, 0, static_cast<int>(width) - 1);
     x1 = std::clamp(x1, 0, static_cast<int>(width) - 1);
     y0 = std::clamp(y0, 0, static_cast<int>(height) - 1);
@@ -112,10 +356,10 @@ float ErosionSimulator::getInterpolatedHeight(const std::vector<std::vector<floa
     float fx = x - x0;
     float fy = y - y0;
 
-    float h00 = heightMap[y0][x0];
-    float h10 = heightMap[y0][x1];
-    float h01 = heightMap[y1][x0];
-    float h11 = heightMap[y1][x1];
+    float h00 = heightField.getHeight(x0, y0);
+    float h10 = heightField.getHeight(x1, y0);
+    float h01 = heightField.getHeight(x0, y1);
+    float h11 = heightField.getHeight(x1, y1);
 
     float h0 = h00 * (1 - fx) + h10 * fx;
     float h1 = h01 * (1 - fx) + h11 * fx;
@@ -4,18 +4,50 @@
 #include <vector>
 #include <cstdint>
 #include <random>
+#include <utility>
+#include "erosion_engine.h"
+#include "material_layers.h"
+#include "tiled_height_store.h"
+#include "erosion_diagnostics.h"
 
-class ErosionSimulator {
+class ErosionSimulator : public ErosionEngine {
 public:
     ErosionSimulator(uint32_t seed = 0);
 
-    std::vector<std::vector<float>> erode(const std::vector<std::vector<float>>& heightMap, uint32_t iterations);
+    std::vector<std::vector<float>> erode(const std::vector<std::vector<float>>& heightMap, uint32_t iterations) override;
+    double erodeInPlace(std::vector<std::vector<float>>& heightMap, uint32_t iterations) override;
+    // Runs the droplet kernel without the net-change bookkeeping.
+    void erodeInPlaceUntracked(std::vector<std::vector<float>>& heightMap, uint32_t iterations) override;
+    // Records every droplet step as a visit, plus the exact amounts each
+    // droplet removed and deposited.
+    double erodeWithDiagnostics(std::vector<std::vector<float>>& heightMap, uint32_t iterations, ErosionDiagnostics& diagnostics) override;
+    void setMaterialLayers(MaterialLayers* layers) override { m_layers = layers; }
+
+    // Erodes an out-of-core terrain one tile at a time: every tile gets
+    // dropletsPerTile droplets starting inside it while it and its eight
+    // neighbours are pinned, so droplets rarely leave the resident set.
+    // Material layers are not supported here. Returns the net change of each
+    // tile's droplets, summed over the tiles.
+    double erodeTiled(TiledHeightStore& store, uint32_t dropletsPerTile);
 
 private:
     std::mt19937 m_rng;
+    MaterialLayers* m_layers;
+    // Cells written in the current batch and their heights before it, kept
+    // between calls so batches don't reallocate
+    std::vector<uint8_t> m_touched;
+    std::vector<std::pair<size_t, float>> m_originals;
     
-    void erodePoint(std::vector<std::vector<float>>& heightMap, uint32_t x, uint32_t y);
-    float getInterpolatedHeight(const std::vector<std::vector<float>>& heightMap, float x, float y);
+    // Tracking is NoChangeTracking or NetChangeTracking, like Diagnostics.
+    template <typename Tracking, typename Diagnostics>
+    double erodeDroplets(std::vector<std::vector<float>>& heightMap, uint32_t iterations, Tracking& tracking, Diagnostics& diagnostics);
+    // HeightField is anything with Terrain's sampling API: getWidth(),
+    // getHeight(), getHeight(x, y) and setHeight(x, y, h). Diagnostics is
+    // NoDiagnostics or CellDiagnostics.
+    template <typename HeightField, typename Diagnostics>
+    void erodePoint(HeightField& heightField, uint32_t x, uint32_t y, Diagnostics& diagnostics);
+    template <typename HeightField>
+    float getInterpolatedHeight(const HeightField& heightField, float x, float y);
 };
 
 #endif // EROSION_SIMULATOR_H
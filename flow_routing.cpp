@@ -0,0 +1,121 @@
+#include "flow_routing.h"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <utility>
+
+namespace {
+    const int kNeighbourX[8] = {-1, 0, 1, -1, 1, -1, 0, 1};
+    const int kNeighbourY[8] = {-1, -1, -1, 0, 0, 1, 1, 1};
+    const float kNeighbourDistance[8] = {1.41421356f, 1.0f, 1.41421356f, 1.0f, 1.0f, 1.41421356f, 1.0f, 1.41421356f};
+}
+
+void FlowRouting::compute(const std::vector<std::vector<float>>& heightMap) {
+    m_height = heightMap.size();
+    m_width = m_height > 0 ? heightMap[0].size() : 0;
+
+    fillDepressions(heightMap);
+    computeReceivers();
+    computeAccumulation();
+}
+
+std::vector<std::vector<float>> FlowRouting::getAccumulationMap() const {
+    std::vector<std::vector<float>> map(m_height, std::vector<float>(m_width));
+    for (uint32_t y = 0; y < m_height; ++y) {
+        for (uint32_t x = 0; x < m_width; ++x) {
+            map[y][x] = m_accumulation[y * m_width + x];
+        }
+    }
+    return map;
+}
+
+void FlowRouting::fillDepressions(const std::vector<std::vector<float>>& heightMap) {
+    uint32_t cellCount = m_width * m_height;
+    m_filled.resize(cellCount);
+    m_stack.clear();
+    m_stack.reserve(cellCount);
+
+    using Entry = std::pair<float, uint32_t>;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> open;
+    std::vector<uint8_t> closed(cellCount, 0);
+
+    // Seed the flood with the border, which drains off the map
+    for (uint32_t y = 0; y < m_height; ++y) {
+        for (uint32_t x = 0; x < m_width; ++x) {
+            if (x == 0 || y == 0 || x == m_width - 1 || y == m_height - 1) {
+                uint32_t index = y * m_width + x;
+                m_filled[index] = heightMap[y][x];
+                closed[index] = 1;
+                open.push({m_filled[index], index});
+            }
+        }
+    }
+
+    // Cells come off the queue in non-decreasing filled height, and each one is
+    // raised just above the cell it was reached from, so the pop order is
+    // already a valid receivers-before-donors stack.
+    while (!open.empty()) {
+        uint32_t index = open.top().second;
+        open.pop();
+        m_stack.push_back(index);
+
+        int x = index % m_width;
+        int y = index / m_width;
+        float spill = std::nextafter(m_filled[index], std::numeric_limits<float>::infinity());
+
+        for (int n = 0; n < 8; ++n) {
+            int nx = x + kNeighbourX[n];
+            int ny = y + kNeighbourY[n];
+            if (nx < 0 || ny < 0 || nx >= static_cast<int>(m_width) || ny >= static_cast<int>(m_height)) {
+                continue;
+            }
+            uint32_t neighbour = ny * m_width + nx;
+            if (closed[neighbour]) {
+                continue;
+            }
+            closed[neighbour] = 1;
+            m_filled[neighbour] = std::max(heightMap[ny][nx], spill);
+            open.push({m_filled[neighbour], neighbour});
+        }
+    }
+}
+
+void FlowRouting::computeReceivers() {
+    m_receivers.resize(m_width * m_height);
+
+    for (uint32_t y = 0; y < m_height; ++y) {
+        for (uint32_t x = 0; x < m_width; ++x) {
+            uint32_t index = y * m_width + x;
+            m_receivers[index] = index;
+
+            if (x == 0 || y == 0 || x == m_width - 1 || y == m_height - 1) {
+                continue;
+            }
+
+            float steepest = 0.0f;
+            for (int n = 0; n < 8; ++n) {
+                uint32_t neighbour = (y + kNeighbourY[n]) * m_width + (x + kNeighbourX[n]);
+                float slope = (m_filled[index] - m_filled[neighbour]) / kNeighbourDistance[n];
+                if (slope > steepest) {
+                    steepest = slope;
+                    m_receivers[index] = neighbour;
+                }
+            }
+        }
+    }
+}
+
+void FlowRouting::computeAccumulation() {
+    m_accumulation.assign(m_width * m_height, 1.0f);
+
+    // Walk from the ridges down so each donor is complete before it is passed on
+    for (auto it = m_stack.rbegin(); it != m_stack.rend(); ++it) {
+        uint32_t index = *it;
+        uint32_t receiver = m_receivers[index];
+        if (receiver != index) {
+            m_accumulation[receiver] += m_accumulation[index];
+        }
+    }
+}
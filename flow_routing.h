@@ -0,0 +1,41 @@
+#ifndef FLOW_ROUTING_H
+#define FLOW_ROUTING_H
+
+#include <vector>
+#include <cstdint>
+
+// D8 flow routing over a height map. Depressions are removed with an
+// epsilon priority-flood first, so every cell drains to the map border.
+// All per-cell results are flat row-major arrays (index = y * width + x).
+class FlowRouting {
+public:
+    void compute(const std::vector<std::vector<float>>& heightMap);
+
+    uint32_t getWidth() const { return m_width; }
+    uint32_t getHeight() const { return m_height; }
+
+    // Pit-filled heights; every interior cell has a strictly lower receiver.
+    const std::vector<float>& getFilledHeights() const { return m_filled; }
+    // Steepest-descent neighbour. Border cells are outlets and receive themselves.
+    const std::vector<uint32_t>& getReceivers() const { return m_receivers; }
+    // Cells ordered so that every receiver comes before its donors.
+    const std::vector<uint32_t>& getStack() const { return m_stack; }
+    // Number of cells draining through each cell, including itself.
+    const std::vector<float>& getAccumulation() const { return m_accumulation; }
+
+    std::vector<std::vector<float>> getAccumulationMap() const;
+
+private:
+    uint32_t m_width = 0;
+    uint32_t m_height = 0;
+    std::vector<float> m_filled;
+    std::vector<uint32_t> m_receivers;
+    std::vector<uint32_t> m_stack;
+    std::vector<float> m_accumulation;
+
+    void fillDepressions(const std::vector<std::vector<float>>& heightMap);
+    void computeReceivers();
+    void computeAccumulation();
+};
+
+#endif // FLOW_ROUTING_H
@@ -0,0 +1,303 @@
+#include "height_pyramid.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    // How far, in cells, a sight line's ends are pulled back from the end
+    // columns, so a line that only touches a side of one does not count as
+    // entering it
+    const float kSightLineEpsilon = 1e-4f;
+
+    // Clips [tMin, tMax] against one slab. Returns false if the ray misses it.
+    bool clipSlab(float origin, float dir, float lo, float hi, float& tMin, float& tMax) {
+        if (dir == 0.0f) {
+            return origin >= lo && origin <= hi;
+        }
+        float t0 = (lo - origin) / dir;
+        float t1 = (hi - origin) / dir;
+        if (t0 > t1) {
+            std::swap(t0, t1);
+        }
+        tMin = std::max(tMin, t0);
+        tMax = std::min(tMax, t1);
+        return tMin <= tMax;
+    }
+
+    // Range of t over which the segment lies inside the column of cell (x, y).
+    void cellSpan(const float origin[3], const float dir[3], float x, float y, float& tIn, float& tOut) {
+        tIn = -std::numeric_limits<float>::infinity();
+        tOut = std::numeric_limits<float>::infinity();
+        if (!clipSlab(origin[0], dir[0], x, x + 1.0f, tIn, tOut) || !clipSlab(origin[1], dir[1], y, y + 1.0f, tIn, tOut)) {
+            tIn = tOut = 0.0f;
+        }
+    }
+}
+
+HeightPyramid::HeightPyramid(const Terrain& terrain) {
+    build(terrain);
+}
+
+void HeightPyramid::build(const Terrain& terrain) {
+    m_width = terrain.getWidth();
+    m_height = terrain.getHeight();
+    m_levels.clear();
+
+    Level base{m_width, m_height, {}, std::vector<float>(static_cast<size_t>(m_width) * m_height)};
+    for (uint32_t y = 0; y < m_height; ++y) {
+        for (uint32_t x = 0; x < m_width; ++x) {
+            base.maxHeight[y * m_width + x] = terrain.getHeight(x, y);
+        }
+    }
+    m_levels.push_back(std::move(base));
+
+    while (m_levels.back().width > 1 || m_levels.back().height > 1) {
+        uint32_t width = (m_levels.back().width + 1) / 2;
+        uint32_t height = (m_levels.back().height + 1) / 2;
+        m_levels.push_back({width, height, std::vector<float>(width * height), std::vector<float>(width * height)});
+
+        uint32_t level = m_levels.size() - 1;
+        for (uint32_t y = 0; y < height; ++y) {
+            for (uint32_t x = 0; x < width; ++x) {
+                updateNode(level, x, y);
+            }
+        }
+    }
+}
+
+void HeightPyramid::refit(const Terrain& terrain, uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1) {
+    x1 = std::min(x1, m_width);
+    y1 = std::min(y1, m_height);
+    if (x0 >= x1 || y0 >= y1) {
+        return;
+    }
+
+    Level& base = m_levels[0];
+    for (uint32_t y = y0; y < y1; ++y) {
+        for (uint32_t x = x0; x < x1; ++x) {
+            base.maxHeight[y * m_width + x] = terrain.getHeight(x, y);
+        }
+    }
+    refitAncestors(x0, y0, x1, y1);
+}
+
+void HeightPyramid::refit(const Terrain& terrain) {
+    if (m_levels.size() < 2) {
+        build(terrain);
+        return;
+    }
+
+    // Collect the level 1 blocks that contain a changed cell
+    Level& base = m_levels[0];
+    std::vector<uint32_t> dirty;
+    std::vector<uint8_t> queued(m_levels[1].width * m_levels[1].height, 0);
+    for (uint32_t y = 0; y < m_height; ++y) {
+        for (uint32_t x = 0; x < m_width; ++x) {
+            float height = terrain.getHeight(x, y);
+            float& stored = base.maxHeight[y * m_width + x];
+            if (height == stored) {
+                continue;
+            }
+            stored = height;
+            uint32_t parent = (y / 2) * m_levels[1].width + x / 2;
+            if (!queued[parent]) {
+                queued[parent] = 1;
+                dirty.push_back(parent);
+            }
+        }
+    }
+
+    // Walk up one level at a time, only queueing parents whose child's bounds moved
+    for (uint32_t level = 1; level < m_levels.size() && !dirty.empty(); ++level) {
+        bool hasParent = level + 1 < m_levels.size();
+        std::vector<uint32_t> nextDirty;
+        std::vector<uint8_t> nextQueued(hasParent ? m_levels[level + 1].width * m_levels[level + 1].height : 0, 0);
+
+        for (uint32_t index : dirty) {
+            uint32_t x = index % m_levels[level].width;
+            uint32_t y = index / m_levels[level].width;
+            if (!updateNode(level, x, y) || !hasParent) {
+                continue;
+            }
+            uint32_t parent = (y / 2) * m_levels[level + 1].width + x / 2;
+            if (!nextQueued[parent]) {
+                nextQueued[parent] = 1;
+                nextDirty.push_back(parent);
+            }
+        }
+        dirty.swap(nextDirty);
+    }
+}
+
+void HeightPyramid::refitAncestors(uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1) {
+    for (uint32_t level = 1; level < m_levels.size(); ++level) {
+        x0 /= 2;
+        y0 /= 2;
+        x1 = (x1 + 1) / 2;
+        y1 = (y1 + 1) / 2;
+        for (uint32_t y = y0; y < y1; ++y) {
+            for (uint32_t x = x0; x < x1; ++x) {
+                updateNode(level, x, y);
+            }
+        }
+    }
+}
+
+float HeightPyramid::nodeMin(uint32_t level, uint32_t index) const {
+    return level == 0 ? m_levels[0].maxHeight[index] : m_levels[level].minHeight[index];
+}
+
+// Recomputes one block from its children. Returns true if its bounds changed.
+bool HeightPyramid::updateNode(uint32_t level, uint32_t x, uint32_t y) {
+    const Level& child = m_levels[level - 1];
+    float minHeight = std::numeric_limits<float>::infinity();
+    float maxHeight = -std::numeric_limits<float>::infinity();
+
+    uint32_t childX1 = std::min(2 * x + 2, child.width);
+    uint32_t childY1 = std::min(2 * y + 2, child.height);
+    for (uint32_t cy = 2 * y; cy < childY1; ++cy) {
+        for (uint32_t cx = 2 * x; cx < childX1; ++cx) {
+            uint32_t index = cy * child.width + cx;
+            minHeight = std::min(minHeight, nodeMin(level - 1, index));
+            maxHeight = std::max(maxHeight, child.maxHeight[index]);
+        }
+    }
+
+    Level& node = m_levels[level];
+    uint32_t index = y * node.width + x;
+    bool changed = node.minHeight[index] != minHeight || node.maxHeight[index] != maxHeight;
+    node.minHeight[index] = minHeight;
+    node.maxHeight[index] = maxHeight;
+    return changed;
+}
+
+RayHit HeightPyramid::intersect(float originX, float originY, float originZ, float dirX, float dirY, float dirZ, float maxT) const {
+    const float origin[3] = {originX, originY, originZ};
+    const float dir[3] = {dirX, dirY, dirZ};
+    RayHit hit;
+    uint32_t top = m_levels.size() - 1;
+    traverse(top, 0, 0, origin, dir, 0.0f, maxT, hit);
+    return hit;
+}
+
+bool HeightPyramid::isVisible(const SightLine& line) const {
+    const float origin[3] = {line.fromX, line.fromY, line.fromZ};
+    const float dir[3] = {line.toX - line.fromX, line.toY - line.fromY, line.toZ - line.fromZ};
+    // The end points sit on top of their own columns, and a line that climbs
+    // to a higher target (or leaves a lower eye) runs inside those columns
+    // for its first and last stretch. Only the cells in between can block.
+    // The epsilon is in cells, so it is scaled to t by the length over the
+    // ground; it never drops below what a float t near 1 can resolve.
+    float length = std::hypot(dir[0], dir[1]);
+    float epsilon = 2.0f * std::numeric_limits<float>::epsilon();
+    if (length > 0.0f) {
+        epsilon = std::max(kSightLineEpsilon / length, epsilon);
+    }
+
+    float tIn, tOut;
+    cellSpan(origin, dir, std::floor(line.fromX), std::floor(line.fromY), tIn, tOut);
+    float tMin = std::max(0.0f, tOut) + epsilon;
+    cellSpan(origin, dir, std::floor(line.toX), std::floor(line.toY), tIn, tOut);
+    float tMax = std::min(1.0f, tIn) - epsilon;
+    if (tMin >= tMax) {
+        return true;
+    }
+
+    RayHit hit;
+    uint32_t top = m_levels.size() - 1;
+    return !traverse(top, 0, 0, origin, dir, tMin, tMax, hit);
+}
+
+void HeightPyramid::areVisible(const std::vector<SightLine>& lines, std::vector<uint8_t>& visible, uint32_t threadCount) const {
+    visible.resize(lines.size());
+    threadCount = std::clamp<uint32_t>(threadCount, 1, std::max<size_t>(lines.size(), 1));
+
+    auto work = [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            visible[i] = isVisible(lines[i]) ? 1 : 0;
+        }
+    };
+
+    std::vector<std::thread> threads;
+    size_t chunk = (lines.size() + threadCount - 1) / threadCount;
+    for (uint32_t t = 1; t < threadCount; ++t) {
+        threads.emplace_back(work, std::min(t * chunk, lines.size()), std::min((t + 1) * chunk, lines.size()));
+    }
+    work(0, std::min(chunk, lines.size()));
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+}
+
+std::vector<std::vector<uint8_t>> HeightPyramid::viewshed(uint32_t observerX, uint32_t observerY, float observerHeight, float targetHeight,
+                                                          uint32_t threadCount) const {
+    const std::vector<float>& heights = m_levels[0].maxHeight;
+    float eyeX = observerX + 0.5f;
+    float eyeY = observerY + 0.5f;
+    float eyeZ = heights[observerY * m_width + observerX] + observerHeight;
+
+    std::vector<SightLine> lines;
+    lines.reserve(static_cast<size_t>(m_width) * m_height);
+    for (uint32_t y = 0; y < m_height; ++y) {
+        for (uint32_t x = 0; x < m_width; ++x) {
+            lines.push_back({eyeX, eyeY, eyeZ, x + 0.5f, y + 0.5f, heights[y * m_width + x] + targetHeight});
+        }
+    }
+
+    std::vector<uint8_t> visible;
+    areVisible(lines, visible, threadCount);
+
+    std::vector<std::vector<uint8_t>> result(m_height, std::vector<uint8_t>(m_width));
+    for (uint32_t y = 0; y < m_height; ++y) {
+        std::copy_n(visible.begin() + static_cast<size_t>(y) * m_width, m_width, result[y].begin());
+    }
+    return result;
+}
+
+bool HeightPyramid::traverse(uint32_t level, uint32_t x, uint32_t y, const float origin[3], const float dir[3],
+                             float tMin, float tMax, RayHit& hit) const {
+    const Level& node = m_levels[level];
+    uint32_t index = y * node.width + x;
+
+    float x0 = static_cast<float>(x << level);
+    float y0 = static_cast<float>(y << level);
+    float x1 = static_cast<float>(std::min((x + 1) << level, m_width));
+    float y1 = static_cast<float>(std::min((y + 1) << level, m_height));
+
+    // Columns are solid all the way down, so the block is open below
+    if (!clipSlab(origin[0], dir[0], x0, x1, tMin, tMax) ||
+        !clipSlab(origin[1], dir[1], y0, y1, tMin, tMax) ||
+        !clipSlab(origin[2], dir[2], -std::numeric_limits<float>::infinity(), node.maxHeight[index], tMin, tMax)) {
+        return false;
+    }
+
+    // Entering at or below the block's minimum means entering solid ground
+    float entryZ = origin[2] + dir[2] * tMin;
+    if (level == 0 || entryZ <= nodeMin(level, index)) {
+        float entryX = origin[0] + dir[0] * tMin;
+        float entryY = origin[1] + dir[1] * tMin;
+        hit.hit = true;
+        hit.t = tMin;
+        hit.x = std::clamp(static_cast<uint32_t>(std::max(entryX, x0)), static_cast<uint32_t>(x0), static_cast<uint32_t>(x1) - 1);
+        hit.y = std::clamp(static_cast<uint32_t>(std::max(entryY, y0)), static_cast<uint32_t>(y0), static_cast<uint32_t>(y1) - 1);
+        return true;
+    }
+
+    // Children front to back; a ray crosses at most one of the two off-diagonal
+    // children, so the first hit found is the nearest.
+    const Level& child = m_levels[level - 1];
+    uint32_t nearX = dir[0] >= 0.0f ? 0 : 1;
+    uint32_t nearY = dir[1] >= 0.0f ? 0 : 1;
+    const uint32_t order[4][2] = {{nearX, nearY}, {1 - nearX, nearY}, {nearX, 1 - nearY}, {1 - nearX, 1 - nearY}};
+
+    for (const auto& offset : order) {
+        uint32_t cx = 2 * x + offset[0];
+        uint32_t cy = 2 * y + offset[1];
+        if (cx >= child.width || cy >= child.height) {
+            continue;
+        }
+        if (traverse(level - 1, cx, cy, origin, dir, tMin, tMax, hit)) {
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,79 @@
+#ifndef HEIGHT_PYRAMID_H
+#define HEIGHT_PYRAMID_H
+
+#include <vector>
+#include <cstdint>
+#include <limits>
+#include <thread>
+#include "terrain.h"
+
+struct RayHit {
+    bool hit = false;
+    float t = 0.0f;     // Ray parameter of the hit point
+    uint32_t x = 0;     // Cell that was hit
+    uint32_t y = 0;
+};
+
+struct SightLine {
+    float fromX, fromY, fromZ;
+    float toX, toY, toZ;
+};
+
+// Min/max height pyramid over a Terrain for ray and line-of-sight queries.
+// Each cell is treated as a solid column [x, x+1] x [y, y+1] x (-inf, height],
+// the same shape the 3D view draws. Level k stores the min and max height of
+// every 2^k x 2^k block, so a query can skip any block whose max is below the
+// ray and report a hit as soon as the ray enters a block below its min.
+// Coordinates are in cells, z is the raw terrain height.
+class HeightPyramid {
+public:
+    explicit HeightPyramid(const Terrain& terrain);
+
+    void build(const Terrain& terrain);
+    // Re-reads the cells in [x0, x1) x [y0, y1) and updates only the blocks
+    // above them.
+    void refit(const Terrain& terrain, uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1);
+    // Finds the cells that changed since the last build/refit and updates
+    // their ancestors, stopping as soon as a block's bounds stay the same.
+    // Cheaper than build() after an erode() step that touched a small part
+    // of the map.
+    void refit(const Terrain& terrain);
+
+    // First hit with t in [0, maxT]. The direction does not need to be normalised.
+    RayHit intersect(float originX, float originY, float originZ, float dirX, float dirY, float dirZ,
+                     float maxT = std::numeric_limits<float>::infinity()) const;
+    // True if no cell between the two end points rises to the segment. The
+    // cells holding the end points never block, so a point on top of a cell
+    // can see and be seen from lower ground.
+    bool isVisible(const SightLine& line) const;
+    void areVisible(const std::vector<SightLine>& lines, std::vector<uint8_t>& visible,
+                    uint32_t threadCount = std::thread::hardware_concurrency()) const;
+    // Visibility of the top of every cell (its centre, raised by targetHeight)
+    // from a point observerHeight above the centre of the observer's cell.
+    std::vector<std::vector<uint8_t>> viewshed(uint32_t observerX, uint32_t observerY, float observerHeight, float targetHeight = 0.0f,
+                                               uint32_t threadCount = std::thread::hardware_concurrency()) const;
+
+    uint32_t getWidth() const { return m_width; }
+    uint32_t getHeight() const { return m_height; }
+    uint32_t getLevelCount() const { return static_cast<uint32_t>(m_levels.size()); }
+
+private:
+    struct Level {
+        uint32_t width;
+        uint32_t height;
+        std::vector<float> minHeight;   // Empty for level 0, where min == max
+        std::vector<float> maxHeight;
+    };
+
+    uint32_t m_width;
+    uint32_t m_height;
+    std::vector<Level> m_levels;
+
+    float nodeMin(uint32_t level, uint32_t index) const;
+    bool updateNode(uint32_t level, uint32_t x, uint32_t y);
+    void refitAncestors(uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1);
+    bool traverse(uint32_t level, uint32_t x, uint32_t y, const float origin[3], const float dir[3],
+                  float tMin, float tMax, RayHit& hit) const;
+};
+
+#endif // HEIGHT_PYRAMID_H
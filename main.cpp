@@ -1,12 +1,19 @@
 #include <iostream>
 #include <memory>
+#include <string>
 #include "terrain.h"
 #include "terrain_visualizer_2d.h"
 #include "perlin_noise_generator.h"
 #include "erosion_simulator.h"
 #include "terrain_visualizer_3d.h"
 
-int main() {
+int main(int argc, char* argv[]) {
+    // --offscreen <prefix> renders headless and writes <prefix>_NNNNNN.ppm frames
+    std::string capturePrefix;
+    if (argc == 3 && std::string(argv[1]) == "--offscreen") {
+        capturePrefix = argv[2];
+    }
+
     uint32_t width = 200;
     uint32_t height = 150;
     uint32_t seed = 30449;  // You can change this seed to get different terrains
@@ -18,10 +25,15 @@ int main() {
     terrain.generate();
 
     try {
-        TerrainVisualizer3D visualizer3D(800, 600);
+        RenderBackend backend = capturePrefix.empty() ? RenderBackend::Window : RenderBackend::Offscreen;
+        TerrainVisualizer3D visualizer3D(800, 600, backend);
+        if (!capturePrefix.empty()) {
+            visualizer3D.setFrameCapture(capturePrefix);
+        }
 
+        // Spend a fixed slice of each frame on erosion regardless of map size
         auto erodeStep = [](Terrain& t) {
-            t.erode(50);
+            t.erodeFor(std::chrono::milliseconds(12));
         };
 
         int fps = 30;
@@ -0,0 +1,53 @@
+#include "material_layers.h"
+#include <algorithm>
+#include <stdexcept>
+
+MaterialLayers::MaterialLayers(uint32_t width, uint32_t height, const std::vector<float>& hardness)
+    : m_width(width), m_height(height), m_layerCount(hardness.size()), m_planeSize(static_cast<size_t>(width) * height) {
+    if (hardness.empty()) {
+        throw std::invalid_argument("MaterialLayers needs at least a bedrock layer");
+    }
+
+    for (float layerHardness : hardness) {
+        if (layerHardness <= 0.0f) {
+            throw std::invalid_argument("Layer hardness must be positive");
+        }
+        m_erodibility.push_back(1.0f / layerHardness);
+    }
+
+    m_thickness.assign((m_layerCount - 1) * m_planeSize, 0.0f);
+}
+
+void MaterialLayers::fill(uint32_t layer, float thickness) {
+    if (layer + 1 >= m_layerCount) {
+        throw std::out_of_range("Bedrock has no thickness");
+    }
+    std::fill_n(getPlane(layer), m_planeSize, thickness);
+}
+
+float MaterialLayers::getThickness(uint32_t layer, uint32_t x, uint32_t y) const {
+    return m_thickness[layer * m_planeSize + y * m_width + x];
+}
+
+void MaterialLayers::setThickness(uint32_t layer, uint32_t x, uint32_t y, float thickness) {
+    m_thickness[layer * m_planeSize + y * m_width + x] = thickness;
+}
+
+uint32_t MaterialLayers::getTopLayer(uint32_t x, uint32_t y) const {
+    const float* cell = &m_thickness[y * m_width + x];
+    uint32_t layer = 0;
+    while (layer + 1 < m_layerCount && cell[layer * m_planeSize] <= 0.0f) {
+        ++layer;
+    }
+    return layer;
+}
+
+void MaterialLayers::erode(uint32_t x, uint32_t y, float amount) {
+    float* cell = &m_thickness[y * m_width + x];
+    for (uint32_t layer = 0; layer + 1 < m_layerCount && amount > 0.0f; ++layer) {
+        float& thickness = cell[layer * m_planeSize];
+        float removed = std::min(thickness, amount);
+        thickness -= removed;
+        amount -= removed;
+    }
+}
@@ -0,0 +1,47 @@
+#ifndef MATERIAL_LAYERS_H
+#define MATERIAL_LAYERS_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// Per-cell material stack for a Terrain, ordered top to bottom (e.g. sediment,
+// soil, bedrock). The bottom layer is unlimited bedrock. Every layer above it
+// stores its thickness as one contiguous width * height plane, so an extra
+// layer costs exactly one float plane and the erosion kernels can find the
+// exposed layer with a few strided loads and no per-cell allocations.
+// Deposited material always goes to layer 0.
+class MaterialLayers {
+public:
+    // hardness[i] is the hardness of layer i; erodibility is 1 / hardness, so a
+    // hardness of 1 erodes exactly like the single-layer model.
+    MaterialLayers(uint32_t width, uint32_t height, const std::vector<float>& hardness);
+
+    uint32_t getWidth() const { return m_width; }
+    uint32_t getHeight() const { return m_height; }
+    uint32_t getLayerCount() const { return m_layerCount; }
+
+    void fill(uint32_t layer, float thickness);
+    float getThickness(uint32_t layer, uint32_t x, uint32_t y) const;
+    void setThickness(uint32_t layer, uint32_t x, uint32_t y, float thickness);
+    // Contiguous thickness plane of a non-bedrock layer.
+    float* getPlane(uint32_t layer) { return &m_thickness[static_cast<size_t>(layer) * m_planeSize]; }
+    const float* getPlane(uint32_t layer) const { return &m_thickness[static_cast<size_t>(layer) * m_planeSize]; }
+
+    uint32_t getTopLayer(uint32_t x, uint32_t y) const;
+    float getErodibility(uint32_t x, uint32_t y) const { return m_erodibility[getTopLayer(x, y)]; }
+
+    // Removes material from the top down; whatever is left comes out of bedrock.
+    void erode(uint32_t x, uint32_t y, float amount);
+    void deposit(uint32_t x, uint32_t y, float amount) { m_thickness[y * m_width + x] += amount; }
+
+private:
+    uint32_t m_width;
+    uint32_t m_height;
+    uint32_t m_layerCount;
+    size_t m_planeSize;
+    std::vector<float> m_erodibility;
+    std::vector<float> m_thickness;     // m_layerCount - 1 planes, bedrock has none
+};
+
+#endif // MATERIAL_LAYERS_H
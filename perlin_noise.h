@@ -1,20 +1,32 @@
 #ifndef PERLIN_NOISE_H
 #define PERLIN_NOISE_H
 
-#include <vector>
+#include <array>
 #include <cstdint>
+#include "perlin_tables.h"
 
 class PerlinNoise {
 public:
     PerlinNoise(uint32_t seed = 0);
+    // Uses prebuilt tables, e.g. PerlinNoise(makePerlinTables(seed)) for the
+    // same noise as BakedPerlinNoise<seed> with a seed known only at runtime.
+    explicit PerlinNoise(const PerlinTables& tables);
     double noise(double x, double y) const;
 
 private:
-    std::vector<int> p;
-    
-    double fade(double t) const;
-    double lerp(double t, double a, double b) const;
-    double grad(int hash, double x, double y) const;
+    std::array<uint8_t, 512> m_permutation;
+};
+
+// PerlinNoise with its tables baked in at compile time for a fixed seed. The
+// table is a static constexpr member, so construction costs nothing and every
+// lookup is a load at a constant address plus the index.
+template <uint32_t Seed>
+class BakedPerlinNoise {
+public:
+    double noise(double x, double y) const { return perlinNoise(kTables.permutation.data(), x, y); }
+
+private:
+    static constexpr PerlinTables kTables = makePerlinTables(Seed);
 };
 
 #endif // PERLIN_NOISE_H
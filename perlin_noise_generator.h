@@ -1,9 +1,48 @@
 #ifndef PERLIN_NOISE_GENERATOR_H
 #define PERLIN_NOISE_GENERATOR_H
 
+#include <vector>
+#include <cstdint>
 #include "terrain_generator.h"
 #include "perlin_noise.h"
 
+// Sums `octaves` layers of noise, halving the amplitude and doubling the
+// frequency each time, and normalises the result to [0, 1]. Noise is any type
+// with noise(x, y), so baked and runtime tables share the loop.
+template <typename Noise>
+std::vector<std::vector<float>> generateFractalNoise(const Noise& noise, uint32_t width, uint32_t height, double baseFrequency, int octaves) {
+    std::vector<std::vector<float>> heightMap(height, std::vector<float>(width, 0.0f));
+
+    for (uint32_t y = 0; y < height; ++y) {
+        for (uint32_t x = 0; x < width; ++x) {
+            double nx = static_cast<double>(x) / width - 0.5;
+            double ny = static_cast<double>(y) / height - 0.5;
+
+            double elevation = 0.0;
+            double amplitude = 1.0;
+            double frequency = baseFrequency;
+            double maxValue = 0.0;
+
+            for (int o = 0; o < octaves; ++o) {
+                double sampleX = nx * frequency;
+                double sampleY = ny * frequency;
+                elevation += noise.noise(sampleX, sampleY) * amplitude;
+
+                maxValue += amplitude;
+                amplitude *= 0.5;
+                frequency *= 2.0;
+            }
+
+            elevation /= maxValue;
+            elevation = (elevation + 1.0) / 2.0;  // Normalize to [0, 1]
+
+            heightMap[y][x] = static_cast<float>(elevation);
+        }
+    }
+
+    return heightMap;
+}
+
 class PerlinNoiseGenerator : public TerrainGenerator {
 public:
     PerlinNoiseGenerator(uint32_t seed = 0, double frequency = 0.1, int octaves = 4);
@@ -15,4 +54,21 @@ private:
     int m_octaves;
 };
 
+// PerlinNoiseGenerator for a production seed fixed at compile time. Its noise
+// is that of PerlinNoise(makePerlinTables(Seed)), not PerlinNoise(Seed).
+template <uint32_t Seed>
+class BakedPerlinNoiseGenerator : public TerrainGenerator {
+public:
+    BakedPerlinNoiseGenerator(double frequency = 0.1, int octaves = 4) : m_frequency(frequency), m_octaves(octaves) {}
+
+    std::vector<std::vector<float>> generate(uint32_t width, uint32_t height) override {
+        return generateFractalNoise(m_perlinNoise, width, height, m_frequency, m_octaves);
+    }
+
+private:
+    BakedPerlinNoise<Seed> m_perlinNoise;
+    double m_frequency;
+    int m_octaves;
+};
+
 #endif // PERLIN_NOISE_GENERATOR_H
@@ -0,0 +1,80 @@
+#ifndef PERLIN_TABLES_H
+#define PERLIN_TABLES_H
+
+#include <array>
+#include <cstdint>
+#include <cmath>
+
+// Permutation of 0..255 stored twice, so permutation[i + 1] never wraps.
+struct PerlinTables {
+    std::array<uint8_t, 512> permutation;
+};
+
+// x and y coefficients of the 16 gradients of improved Perlin noise, indexed
+// by hash & 15. The multiplies are by 0 or +-1, so results match the
+// classic branching grad() exactly.
+inline constexpr double kPerlinGradients[16][2] = {
+    {1, 1}, {-1, 1}, {1, -1}, {-1, -1},
+    {1, 0}, {-1, 0}, {1, 0}, {-1, 0},
+    {0, 1}, {0, -1}, {0, 1}, {0, -1},
+    {1, 1}, {0, -1}, {-1, 1}, {0, -1},
+};
+
+// Fisher-Yates shuffle driven by splitmix64, so tables can be built at
+// compile time and are the same with every standard library. This is a
+// different permutation from PerlinNoise(seed), which uses std::shuffle.
+constexpr PerlinTables makePerlinTables(uint32_t seed) {
+    PerlinTables tables{};
+    for (int i = 0; i < 256; ++i) {
+        tables.permutation[i] = static_cast<uint8_t>(i);
+    }
+
+    uint64_t state = seed;
+    for (int i = 255; i > 0; --i) {
+        state += 0x9E3779B97F4A7C15ull;
+        uint64_t z = state;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        z ^= z >> 31;
+        int j = static_cast<int>(z % static_cast<uint64_t>(i + 1));
+
+        uint8_t swapped = tables.permutation[i];
+        tables.permutation[i] = tables.permutation[j];
+        tables.permutation[j] = swapped;
+    }
+
+    for (int i = 0; i < 256; ++i) {
+        tables.permutation[256 + i] = tables.permutation[i];
+    }
+    return tables;
+}
+
+// 2D improved Perlin noise over a doubled permutation, shared by PerlinNoise
+// and BakedPerlinNoise.
+inline double perlinNoise(const uint8_t* permutation, double x, double y) {
+    auto fade = [](double t) { return t * t * t * (t * (t * 6 - 15) + 10); };
+    auto lerp = [](double t, double a, double b) { return a + t * (b - a); };
+    auto grad = [](int hash, double gx, double gy) {
+        const double* gradient = kPerlinGradients[hash & 15];
+        return gradient[0] * gx + gradient[1] * gy;
+    };
+
+    int X = static_cast<int>(std::floor(x)) & 255;
+    int Y = static_cast<int>(std::floor(y)) & 255;
+
+    x -= std::floor(x);
+    y -= std::floor(y);
+
+    double u = fade(x);
+    double v = fade(y);
+
+    int A = permutation[X] + Y;
+    int B = permutation[X + 1] + Y;
+
+    return lerp(v, lerp(u, grad(permutation[A], x, y),
+                           grad(permutation[B], x - 1, y)),
+                   lerp(u, grad(permutation[A + 1], x, y - 1),
+                           grad(permutation[B + 1], x - 1, y - 1)));
+}
+
+#endif // PERLIN_TABLES_H
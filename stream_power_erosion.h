@@ -0,0 +1,41 @@
+#ifndef STREAM_POWER_EROSION_H
+#define STREAM_POWER_EROSION_H
+
+#include <vector>
+#include <cstdint>
+#include "erosion_engine.h"
+#include "flow_routing.h"
+#include "material_layers.h"
+
+// Detachment-limited stream-power erosion, dh/dt = U - K * A^m * S, solved
+// implicitly along the D8 receiver tree (Braun & Willett 2013). The implicit
+// update is unconditionally stable, so each iteration can take a large time
+// step and a map settles into a drainage network in tens of iterations.
+class StreamPowerErosion : public ErosionEngine {
+public:
+    StreamPowerErosion(float erodibility = 0.01f, float areaExponent = 0.5f, float timeStep = 1.0f, float upliftRate = 0.0f);
+
+    // One iteration re-routes flow over the current surface and applies one
+    // implicit time step. Depressions are filled as part of the routing.
+    std::vector<std::vector<float>> erode(const std::vector<std::vector<float>>& heightMap, uint32_t iterations) override;
+    double erodeInPlace(std::vector<std::vector<float>>& heightMap, uint32_t iterations) override;
+    // Scales K by the erodibility of the exposed layer. Filled depressions are
+    // deposited as sediment.
+    void setMaterialLayers(MaterialLayers* layers) override { m_layers = layers; }
+
+    // Routing of the surface before the last applied time step.
+    const FlowRouting& getFlowRouting() const { return m_routing; }
+    std::vector<std::vector<float>> getFlowAccumulation() const { return m_routing.getAccumulationMap(); }
+
+private:
+    float m_erodibility;
+    float m_areaExponent;
+    float m_timeStep;
+    float m_upliftRate;
+    FlowRouting m_routing;
+    MaterialLayers* m_layers;
+
+    void applyTimeStep(std::vector<float>& heights);
+};
+
+#endif // STREAM_POWER_EROSION_H
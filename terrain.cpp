@@ -1,7 +1,9 @@
 #include "terrain.h"
+#include <algorithm>
+#include <stdexcept>
 
-Terrain::Terrain(uint32_t width, uint32_t height, std::unique_ptr<TerrainGenerator> generator, std::unique_ptr<ErosionSimulator> erosionSimulator)
-    : m_width(width), m_height(height), m_generator(std::move(generator)), m_erosionSimulator(std::move(erosionSimulator)) {
+Terrain::Terrain(uint32_t width, uint32_t height, std::unique_ptr<TerrainGenerator> generator, std::unique_ptr<ErosionEngine> erosionEngine)
+    : m_width(width), m_height(height), m_generator(std::move(generator)), m_erosionEngine(std::move(erosionEngine)) {
     m_heightMap.resize(height, std::vector<float>(width, 0.0f));
 }
 
@@ -10,7 +12,66 @@ void Terrain::generate() {
 }
 
 void Terrain::erode(uint32_t iterations) {
-    m_heightMap = m_erosionSimulator->erode(m_heightMap, iterations);
+    m_erosionEngine->erodeInPlaceUntracked(m_heightMap, iterations);
+}
+
+void Terrain::erode(uint32_t iterations, ErosionDiagnostics& diagnostics) {
+    m_erosionEngine->erodeWithDiagnostics(m_heightMap, iterations, diagnostics);
+}
+
+ErosionReport Terrain::erodeFor(std::chrono::microseconds budget, uint32_t batchIterations) {
+    using Clock = std::chrono::steady_clock;
+    ErosionReport report;
+    auto start = Clock::now();
+    double cellCount = static_cast<double>(m_width) * m_height;
+
+    while (true) {
+        double change = m_erosionEngine->erodeInPlace(m_heightMap, batchIterations);
+        report.iterations += batchIterations;
+        report.batches++;
+        report.meanHeightChange = static_cast<float>(change / cellCount);
+
+        // Stop if another batch of average cost would not fit
+        auto elapsed = Clock::now() - start;
+        auto averageBatch = elapsed / report.batches;
+        if (elapsed + averageBatch > budget) {
+            break;
+        }
+    }
+
+    report.elapsedMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    return report;
+}
+
+ErosionReport Terrain::erodeUntilConverged(float threshold, uint32_t batchIterations, uint32_t maxIterations) {
+    using Clock = std::chrono::steady_clock;
+    ErosionReport report;
+    auto start = Clock::now();
+    double cellCount = static_cast<double>(m_width) * m_height;
+
+    while (report.iterations < maxIterations) {
+        uint32_t batch = std::min(batchIterations, maxIterations - report.iterations);
+        double change = m_erosionEngine->erodeInPlace(m_heightMap, batch);
+        report.iterations += batch;
+        report.batches++;
+        report.meanHeightChange = static_cast<float>(change / cellCount);
+
+        if (report.meanHeightChange < threshold) {
+            report.converged = true;
+            break;
+        }
+    }
+
+    report.elapsedMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    return report;
+}
+
+void Terrain::setMaterialLayers(std::unique_ptr<MaterialLayers> layers) {
+    if (layers && (layers->getWidth() != m_width || layers->getHeight() != m_height)) {
+        throw std::invalid_argument("Material layers must match the terrain size");
+    }
+    m_materialLayers = std::move(layers);
+    m_erosionEngine->setMaterialLayers(m_materialLayers.get());
 }
 
 float Terrain::getHeight(uint32_t x, uint32_t y) const {
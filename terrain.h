@@ -3,16 +3,42 @@
 
 #include <vector>
 #include <cstdint>
+#include <chrono>
+#include <limits>
 #include <memory>
 #include "terrain_generator.h"
-#include "erosion_simulator.h"
+#include "erosion_engine.h"
+#include "material_layers.h"
+#include "erosion_diagnostics.h"
+
+struct ErosionReport {
+    uint32_t iterations = 0;        // Engine iterations run (droplets for ErosionSimulator)
+    uint32_t batches = 0;
+    double elapsedMs = 0.0;
+    float meanHeightChange = 0.0f;  // Mean per-cell |net height change| over the last batch
+    bool converged = false;
+};
 
 class Terrain {
 public:
-    Terrain(uint32_t width, uint32_t height, std::unique_ptr<TerrainGenerator> generator, std::unique_ptr<ErosionSimulator> erosionSimulator);
+    Terrain(uint32_t width, uint32_t height, std::unique_ptr<TerrainGenerator> generator, std::unique_ptr<ErosionEngine> erosionEngine);
 
     void generate();
     void erode(uint32_t iterations);
+    // Also adds per-cell visit/eroded/deposited totals to diagnostics.
+    void erode(uint32_t iterations, ErosionDiagnostics& diagnostics);
+    // Runs batches of erosion until the next batch would overrun the budget.
+    // At least one batch always runs.
+    ErosionReport erodeFor(std::chrono::microseconds budget, uint32_t batchIterations = 50);
+    // Runs batches until the mean absolute height change of a batch drops below
+    // threshold, or maxIterations have been run.
+    ErosionReport erodeUntilConverged(float threshold, uint32_t batchIterations = 1000,
+                                      uint32_t maxIterations = std::numeric_limits<uint32_t>::max());
+    // Gives the terrain a material stack of the same size; the erosion engine
+    // reads hardness from it and keeps the layer thicknesses up to date.
+    void setMaterialLayers(std::unique_ptr<MaterialLayers> layers);
+    MaterialLayers* getMaterialLayers() const { return m_materialLayers.get(); }
+
     float getHeight(uint32_t x, uint32_t y) const;
     void setHeight(uint32_t x, uint32_t y, float height);
 
@@ -24,7 +50,8 @@ private:
     uint32_t m_height;
     std::vector<std::vector<float>> m_heightMap;
     std::unique_ptr<TerrainGenerator> m_generator;
-    std::unique_ptr<ErosionSimulator> m_erosionSimulator;
+    std::unique_ptr<ErosionEngine> m_erosionEngine;
+    std::unique_ptr<MaterialLayers> m_materialLayers;
 };
 
 #endif // TERRAIN_H
@@ -0,0 +1,75 @@
+#include "terrain_exporter.h"
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+    // Works on anything with Terrain's sampling API
+    template <typename HeightSource>
+    void writePGM(const HeightSource& terrain, const std::string& path) {
+        std::ofstream file(path, std::ios::binary);
+        if (!file) {
+            throw std::runtime_error("Could not open " + path + " for writing");
+        }
+
+        uint32_t width = terrain.getWidth();
+        uint32_t height = terrain.getHeight();
+        file << "P5\n" << width << " " << height << "\n65535\n";
+
+        // PGM stores 16-bit samples most significant byte first
+        std::vector<unsigned char> row(width * 2);
+        for (uint32_t y = 0; y < height; ++y) {
+            for (uint32_t x = 0; x < width; ++x) {
+                float h = std::clamp(terrain.getHeight(x, y), 0.0f, 1.0f);
+                uint16_t sample = static_cast<uint16_t>(h * 65535.0f + 0.5f);
+                row[x * 2] = static_cast<unsigned char>(sample >> 8);
+                row[x * 2 + 1] = static_cast<unsigned char>(sample & 0xFF);
+            }
+            file.write(reinterpret_cast<const char*>(row.data()), row.size());
+        }
+
+        if (!file) {
+            throw std::runtime_error("Failed writing " + path);
+        }
+    }
+
+    template <typename HeightSource>
+    void writeRaw(const HeightSource& terrain, const std::string& path) {
+        std::ofstream file(path, std::ios::binary);
+        if (!file) {
+            throw std::runtime_error("Could not open " + path + " for writing");
+        }
+
+        uint32_t width = terrain.getWidth();
+        uint32_t height = terrain.getHeight();
+
+        std::vector<float> row(width);
+        for (uint32_t y = 0; y < height; ++y) {
+            for (uint32_t x = 0; x < width; ++x) {
+                row[x] = terrain.getHeight(x, y);
+            }
+            file.write(reinterpret_cast<const char*>(row.data()), row.size() * sizeof(float));
+        }
+
+        if (!file) {
+            throw std::runtime_error("Failed writing " + path);
+        }
+    }
+}
+
+void TerrainExporter::exportPGM(const Terrain& terrain, const std::string& path) {
+    writePGM(terrain, path);
+}
+
+void TerrainExporter::exportPGM(const TiledHeightStore& store, const std::string& path) {
+    writePGM(store, path);
+}
+
+void TerrainExporter::exportRaw(const Terrain& terrain, const std::string& path) {
+    writeRaw(terrain, path);
+}
+
+void TerrainExporter::exportRaw(const TiledHeightStore& store, const std::string& path) {
+    writeRaw(store, path);
+}
@@ -0,0 +1,20 @@
+#ifndef TERRAIN_EXPORTER_H
+#define TERRAIN_EXPORTER_H
+
+#include "terrain.h"
+#include "tiled_height_store.h"
+#include <string>
+
+// Both formats are written row by row, so a TiledHeightStore being exported
+// should be able to cache at least one full row of tiles.
+class TerrainExporter {
+public:
+    // 16-bit binary PGM, heights clamped to [0, 1].
+    static void exportPGM(const Terrain& terrain, const std::string& path);
+    static void exportPGM(const TiledHeightStore& store, const std::string& path);
+    // Raw native-endian float32 rows, no header.
+    static void exportRaw(const Terrain& terrain, const std::string& path);
+    static void exportRaw(const TiledHeightStore& store, const std::string& path);
+};
+
+#endif // TERRAIN_EXPORTER_H
@@ -0,0 +1,167 @@
+#include "terrain_job_scheduler.h"
+#include <algorithm>
+
+namespace {
+    enum Stage { StageGenerate = 0, StageErode = 1, StageExport = 2 };
+}
+
+TerrainJobScheduler::TerrainJobScheduler(TerrainFactory factory, ExportFunction exporter,
+                                         uint32_t workerThreads, uint32_t maxInFlight, uint32_t exportThreads)
+    : m_factory(std::move(factory)), m_exporter(std::move(exporter)), m_pool(workerThreads),
+      m_maxInFlight(maxInFlight), m_stopping(false), m_inFlight(0) {
+    // Enough terrains to keep every worker busy while the writers drain the rest
+    if (m_maxInFlight == 0) {
+        m_maxInFlight = m_pool.getThreadCount() * 2;
+    }
+
+    for (int stage = 0; stage < 3; ++stage) {
+        m_stageCompleted[stage] = 0;
+        m_stageBusyNanos[stage] = 0;
+    }
+
+    exportThreads = std::max(exportThreads, 1u);
+    for (uint32_t i = 0; i < exportThreads; ++i) {
+        m_exportThreads.emplace_back(&TerrainJobScheduler::exportLoop, this);
+    }
+}
+
+TerrainJobScheduler::~TerrainJobScheduler() {
+    {
+        std::lock_guard<std::mutex> lock(m_exportMutex);
+        m_stopping = true;
+    }
+    m_exportReady.notify_all();
+
+    for (std::thread& thread : m_exportThreads) {
+        thread.join();
+    }
+}
+
+PipelineStats TerrainJobScheduler::run(const std::vector<TerrainJob>& jobs) {
+    for (int stage = 0; stage < 3; ++stage) {
+        m_stageCompleted[stage] = 0;
+        m_stageBusyNanos[stage] = 0;
+    }
+    m_firstError = nullptr;
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (const TerrainJob& job : jobs) {
+        {
+            // Back-pressure: don't start generating until a terrain slot is free
+            std::unique_lock<std::mutex> lock(m_slotMutex);
+            m_slotFreed.wait(lock, [this] { return m_inFlight < m_maxInFlight; });
+            ++m_inFlight;
+        }
+
+        JobState* state = new JobState{job, nullptr};
+        m_pool.submit([this, state] {
+            generateStage(std::unique_ptr<JobState>(state));
+        });
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(m_slotMutex);
+        m_slotFreed.wait(lock, [this] { return m_inFlight == 0; });
+    }
+
+    PipelineStats stats;
+    stats.wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    StageStats* stageStats[3] = {&stats.generate, &stats.erode, &stats.exportStage};
+    for (int stage = 0; stage < 3; ++stage) {
+        stageStats[stage]->completed = m_stageCompleted[stage].load();
+        stageStats[stage]->busySeconds = m_stageBusyNanos[stage].load() * 1e-9;
+    }
+
+    if (m_firstError) {
+        std::rethrow_exception(m_firstError);
+    }
+
+    return stats;
+}
+
+void TerrainJobScheduler::generateStage(std::unique_ptr<JobState> state) {
+    auto start = std::chrono::steady_clock::now();
+    try {
+        state->terrain = m_factory(state->job.seed);
+        state->terrain->generate();
+    } catch (...) {
+        recordError();
+        releaseSlot();
+        return;
+    }
+    recordStage(StageGenerate, start);
+
+    // Submitted from a worker, so it lands on this worker's own deque and
+    // usually runs next while the height map is still in cache.
+    JobState* next = state.release();
+    m_pool.submit([this, next] {
+        erodeStage(std::unique_ptr<JobState>(next));
+    });
+}
+
+void TerrainJobScheduler::erodeStage(std::unique_ptr<JobState> state) {
+    auto start = std::chrono::steady_clock::now();
+    try {
+        state->terrain->erode(state->job.erosionIterations);
+    } catch (...) {
+        recordError();
+        releaseSlot();
+        return;
+    }
+    recordStage(StageErode, start);
+
+    {
+        std::lock_guard<std::mutex> lock(m_exportMutex);
+        m_exportQueue.push_back(std::move(state));
+    }
+    m_exportReady.notify_one();
+}
+
+void TerrainJobScheduler::exportLoop() {
+    while (true) {
+        std::unique_ptr<JobState> state;
+        {
+            std::unique_lock<std::mutex> lock(m_exportMutex);
+            m_exportReady.wait(lock, [this] { return m_stopping || !m_exportQueue.empty(); });
+            if (m_exportQueue.empty()) {
+                return;
+            }
+            state = std::move(m_exportQueue.front());
+            m_exportQueue.pop_front();
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        try {
+            m_exporter(*state->terrain, state->job);
+            recordStage(StageExport, start);
+        } catch (...) {
+            recordError();
+        }
+
+        state.reset();
+        releaseSlot();
+    }
+}
+
+void TerrainJobScheduler::recordStage(int stage, std::chrono::steady_clock::time_point start) {
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+    m_stageCompleted[stage].fetch_add(1, std::memory_order_relaxed);
+    m_stageBusyNanos[stage].fetch_add(elapsed.count(), std::memory_order_relaxed);
+}
+
+void TerrainJobScheduler::recordError() {
+    std::lock_guard<std::mutex> lock(m_errorMutex);
+    if (!m_firstError) {
+        m_firstError = std::current_exception();
+    }
+}
+
+void TerrainJobScheduler::releaseSlot() {
+    {
+        std::lock_guard<std::mutex> lock(m_slotMutex);
+        --m_inFlight;
+    }
+    m_slotFreed.notify_all();
+}
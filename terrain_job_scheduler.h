@@ -0,0 +1,92 @@
+#ifndef TERRAIN_JOB_SCHEDULER_H
+#define TERRAIN_JOB_SCHEDULER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "terrain.h"
+#include "work_stealing_pool.h"
+
+struct TerrainJob {
+    uint32_t seed;
+    uint32_t erosionIterations;
+    std::string outputPath;
+};
+
+struct StageStats {
+    uint64_t completed = 0;
+    double busySeconds = 0.0;   // Summed over all threads that ran the stage
+
+    double getThroughput(double wallSeconds) const { return wallSeconds > 0.0 ? completed / wallSeconds : 0.0; }
+};
+
+struct PipelineStats {
+    StageStats generate;
+    StageStats erode;
+    StageStats exportStage;
+    double wallSeconds = 0.0;
+};
+
+// Runs generate -> erode -> export for many seeds at once. Generate and erode
+// run as tasks on a shared work-stealing pool, export runs on dedicated writer
+// threads so disk I/O overlaps with compute. At most maxInFlight terrains are
+// alive at any time; the generate stage blocks until one is exported.
+class TerrainJobScheduler {
+public:
+    using TerrainFactory = std::function<std::unique_ptr<Terrain>(uint32_t seed)>;
+    using ExportFunction = std::function<void(const Terrain& terrain, const TerrainJob& job)>;
+
+    TerrainJobScheduler(TerrainFactory factory, ExportFunction exporter,
+                        uint32_t workerThreads = std::thread::hardware_concurrency(),
+                        uint32_t maxInFlight = 0, uint32_t exportThreads = 1);
+    ~TerrainJobScheduler();
+
+    // Blocks until every job is exported. Rethrows the first exception thrown
+    // by any stage once the in-flight jobs have drained.
+    PipelineStats run(const std::vector<TerrainJob>& jobs);
+
+private:
+    struct JobState {
+        TerrainJob job;
+        std::unique_ptr<Terrain> terrain;
+    };
+
+    TerrainFactory m_factory;
+    ExportFunction m_exporter;
+    WorkStealingPool m_pool;
+    uint32_t m_maxInFlight;
+
+    std::vector<std::thread> m_exportThreads;
+    std::deque<std::unique_ptr<JobState>> m_exportQueue;
+    std::mutex m_exportMutex;
+    std::condition_variable m_exportReady;
+    bool m_stopping;
+
+    std::mutex m_slotMutex;
+    std::condition_variable m_slotFreed;
+    uint32_t m_inFlight;
+
+    std::atomic<uint64_t> m_stageCompleted[3];
+    std::atomic<uint64_t> m_stageBusyNanos[3];
+
+    std::mutex m_errorMutex;
+    std::exception_ptr m_firstError;
+
+    void generateStage(std::unique_ptr<JobState> state);
+    void erodeStage(std::unique_ptr<JobState> state);
+    void exportLoop();
+    void recordStage(int stage, std::chrono::steady_clock::time_point start);
+    void recordError();
+    void releaseSlot();
+};
+
+#endif // TERRAIN_JOB_SCHEDULER_H
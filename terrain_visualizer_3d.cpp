@@ -1,6 +1,13 @@
 #include "terrain_visualizer_3d.h"
+#ifdef TERRAIN_ENABLE_EGL
+#include <EGL/eglext.h>
+#endif
 #include <iostream>
+#include <algorithm>
 #include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
 #include <thread>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
@@ -44,18 +51,86 @@ const char* fragmentShaderSource = R"(
     }
 )";
 
-TerrainVisualizer3D::TerrainVisualizer3D(int windowWidth, int windowHeight)
-    : m_windowWidth(windowWidth), m_windowHeight(windowHeight) {
+// Height-texture mode: the grid is static, heights come from a float texture
+// and colour from a (height, erosionStage) ramp baked from getColorForHeight.
+const char* heightVertexShaderSource = R"(
+    #version 330 core
+    layout (location = 0) in vec2 aCell;
+    out vec3 FragPos;
+    out vec3 Normal;
+    out vec3 Color;
+    uniform mat4 model;
+    uniform mat4 view;
+    uniform mat4 projection;
+    uniform sampler2D heightMap;
+    uniform sampler2D colorRamp;
+    uniform float heightScale;
+    uniform float erosionStage;
+    float heightAt(ivec2 cell) {
+        ivec2 size = textureSize(heightMap, 0);
+        return texelFetch(heightMap, clamp(cell, ivec2(0), size - 1), 0).r;
+    }
+    void main() {
+        ivec2 cell = ivec2(aCell);
+        float height = heightAt(cell);
+        float dx = (heightAt(cell + ivec2(1, 0)) - heightAt(cell - ivec2(1, 0))) * heightScale;
+        float dz = (heightAt(cell + ivec2(0, 1)) - heightAt(cell - ivec2(0, 1))) * heightScale;
+        vec3 normal = vec3(-dx, 2.0, -dz);
+
+        // Texel i of either axis was baked for i / (size - 1), so both
+        // coordinates land on texel centres
+        vec2 rampSize = vec2(textureSize(colorRamp, 0));
+        float u = (clamp(height, 0.0, 1.0) * (rampSize.x - 1.0) + 0.5) / rampSize.x;
+        float v = (clamp(erosionStage, 0.0, 1.0) * (rampSize.y - 1.0) + 0.5) / rampSize.y;
+        Color = texture(colorRamp, vec2(u, v)).rgb;
+
+        // Cell centre at the top of the cube the other mode would draw
+        vec3 position = vec3(aCell.x + 0.5, height * heightScale + 1.0, aCell.y + 0.5);
+        FragPos = vec3(model * vec4(position, 1.0));
+        Normal = mat3(transpose(inverse(model))) * normal;
+        gl_Position = projection * view * vec4(FragPos, 1.0);
+    }
+)";
+
+const int kColorRampSize = 256;
+const int kColorRampStages = 16;
+const float kHeightScale = 20.0f;
+
+TerrainVisualizer3D::TerrainVisualizer3D(int windowWidth, int windowHeight, RenderBackend backend)
+    : m_backend(backend), m_window(nullptr), m_windowWidth(windowWidth), m_windowHeight(windowHeight),
+#ifdef TERRAIN_ENABLE_EGL
+      m_eglDisplay(EGL_NO_DISPLAY), m_eglContext(EGL_NO_CONTEXT),
+#endif
+      m_framebuffer(0), m_colorRenderbuffer(0), m_depthRenderbuffer(0), m_captureBuffers{},
+      m_captureWidth(0), m_captureHeight(0), m_capturedFrames(0), m_writtenFrames(0),
+      m_renderMode(RenderMode::Cubes), m_heightShaderProgram(0), m_gridVAO(0), m_gridVBO(0), m_gridEBO(0),
+      m_gridIndexCount(0), m_gridWidth(0), m_gridHeight(0), m_heightTexture(0), m_colorRampTexture(0), m_erosionStage(0.0f),
+      m_terrainWidth(0), m_terrainHeight(0) {
     initOpenGL();
     setupShaders();
     setupBuffers();
 }
 
 TerrainVisualizer3D::~TerrainVisualizer3D() {
+    try {
+        flushFrameCapture();
+    } catch (const std::exception& e) {
+        std::cerr << "Error writing captured frames: " << e.what() << std::endl;
+    }
     cleanupOpenGL();
 }
 
 void TerrainVisualizer3D::initOpenGL() {
+    if (m_backend == RenderBackend::Offscreen) {
+        initOffscreen();
+    } else {
+        initWindow();
+    }
+
+    glEnable(GL_DEPTH_TEST);
+}
+
+void TerrainVisualizer3D::initWindow() {
     if (!glfwInit()) {
         throw std::runtime_error("Failed to initialize GLFW");
     }
@@ -76,8 +151,86 @@ void TerrainVisualizer3D::initOpenGL() {
     if (glewInit() != GLEW_OK) {
         throw std::runtime_error("Failed to initialize GLEW");
     }
+}
 
-    glEnable(GL_DEPTH_TEST);
+void TerrainVisualizer3D::initOffscreen() {
+#ifdef TERRAIN_ENABLE_EGL
+    // Prefer Mesa's surfaceless platform, which needs neither X11 nor a GPU
+    auto getPlatformDisplay = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+    if (getPlatformDisplay) {
+        m_eglDisplay = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+    }
+    if (m_eglDisplay == EGL_NO_DISPLAY) {
+        m_eglDisplay = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    }
+    if (m_eglDisplay == EGL_NO_DISPLAY || !eglInitialize(m_eglDisplay, NULL, NULL)) {
+        throw std::runtime_error("Failed to initialize EGL display");
+    }
+
+    if (!eglBindAPI(EGL_OPENGL_API)) {
+        throw std::runtime_error("EGL does not support desktop OpenGL");
+    }
+
+    const EGLint configAttribs[] = {
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_NONE
+    };
+    EGLConfig config = NULL;
+    EGLint configCount = 0;
+    if (!eglChooseConfig(m_eglDisplay, configAttribs, &config, 1, &configCount) || configCount == 0) {
+        config = NULL; // EGL_KHR_no_config_context: we never create a surface
+    }
+
+    const EGLint contextAttribs[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 3,
+        EGL_CONTEXT_MINOR_VERSION, 3,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE
+    };
+    m_eglContext = eglCreateContext(m_eglDisplay, config, EGL_NO_CONTEXT, contextAttribs);
+    if (m_eglContext == EGL_NO_CONTEXT) {
+        throw std::runtime_error("Failed to create EGL context");
+    }
+    if (!eglMakeCurrent(m_eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, m_eglContext)) {
+        throw std::runtime_error("Failed to make surfaceless EGL context current");
+    }
+
+    // GLEW built for GLX reports a missing X display after it has already
+    // loaded the core entry points, which is all we need here.
+    glewExperimental = GL_TRUE;
+    GLenum glewStatus = glewInit();
+#ifdef GLEW_ERROR_NO_GLX_DISPLAY
+    if (glewStatus == GLEW_ERROR_NO_GLX_DISPLAY) {
+        glewStatus = GLEW_OK;
+    }
+#endif
+    if (glewStatus != GLEW_OK) {
+        throw std::runtime_error("Failed to initialize GLEW");
+    }
+
+    glGenFramebuffers(1, &m_framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+
+    glGenRenderbuffers(1, &m_colorRenderbuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, m_colorRenderbuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, m_windowWidth, m_windowHeight);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_colorRenderbuffer);
+
+    glGenRenderbuffers(1, &m_depthRenderbuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, m_depthRenderbuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, m_windowWidth, m_windowHeight);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_depthRenderbuffer);
+
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        throw std::runtime_error("Offscreen framebuffer is incomplete");
+    }
+
+    // The FBO stays bound for the lifetime of the visualizer
+    glViewport(0, 0, m_windowWidth, m_windowHeight);
+#else
+    throw std::runtime_error("Offscreen rendering requires building with TERRAIN_ENABLE_EGL");
+#endif
 }
 
 void TerrainVisualizer3D::cleanupOpenGL() {
@@ -85,49 +238,284 @@ void TerrainVisualizer3D::cleanupOpenGL() {
     glDeleteBuffers(1, &m_VBO);
     glDeleteBuffers(1, &m_EBO);
     glDeleteProgram(m_shaderProgram);
+    glDeleteProgram(m_heightShaderProgram);
+    glDeleteVertexArrays(1, &m_gridVAO);
+    glDeleteBuffers(1, &m_gridVBO);
+    glDeleteBuffers(1, &m_gridEBO);
+    glDeleteTextures(1, &m_heightTexture);
+    glDeleteTextures(1, &m_colorRampTexture);
+
+    if (!m_capturePrefix.empty()) {
+        glDeleteBuffers(kCaptureBufferCount, m_captureBuffers);
+    }
 
-    glfwDestroyWindow(m_window);
-    glfwTerminate();
+    if (m_backend == RenderBackend::Offscreen) {
+        glDeleteRenderbuffers(1, &m_depthRenderbuffer);
+        glDeleteRenderbuffers(1, &m_colorRenderbuffer);
+        glDeleteFramebuffers(1, &m_framebuffer);
+#ifdef TERRAIN_ENABLE_EGL
+        eglMakeCurrent(m_eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        eglDestroyContext(m_eglDisplay, m_eglContext);
+        eglTerminate(m_eglDisplay);
+#endif
+    } else {
+        glfwDestroyWindow(m_window);
+        glfwTerminate();
+    }
 }
 
-void TerrainVisualizer3D::setupShaders() {
+void TerrainVisualizer3D::setFrameCapture(const std::string& pathPrefix) {
+    flushFrameCapture();
+
+    if (pathPrefix.empty()) {
+        if (!m_capturePrefix.empty()) {
+            glDeleteBuffers(kCaptureBufferCount, m_captureBuffers);
+        }
+        m_capturePrefix.clear();
+        return;
+    }
+
+    if (m_backend == RenderBackend::Offscreen) {
+        m_captureWidth = m_windowWidth;
+        m_captureHeight = m_windowHeight;
+    } else {
+        // May differ from the window size on high-DPI displays
+        glfwGetFramebufferSize(m_window, &m_captureWidth, &m_captureHeight);
+    }
+
+    if (m_capturePrefix.empty()) {
+        glGenBuffers(kCaptureBufferCount, m_captureBuffers);
+    }
+    for (int i = 0; i < kCaptureBufferCount; ++i) {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, m_captureBuffers[i]);
+        glBufferData(GL_PIXEL_PACK_BUFFER, static_cast<GLsizeiptr>(m_captureWidth) * m_captureHeight * 4, NULL, GL_STREAM_READ);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    m_capturePrefix = pathPrefix;
+}
+
+void TerrainVisualizer3D::flushFrameCapture() {
+    while (m_writtenFrames < m_capturedFrames) {
+        writeCapturedFrame(m_writtenFrames++);
+    }
+}
+
+void TerrainVisualizer3D::presentFrame() {
+    if (!m_capturePrefix.empty()) {
+        captureFrame();
+    }
+
+    if (m_backend == RenderBackend::Window) {
+        glfwSwapBuffers(m_window);
+    } else {
+        glFlush();
+    }
+}
+
+void TerrainVisualizer3D::captureFrame() {
+    // Queue the readback into this frame's buffer; glReadPixels returns
+    // immediately when a pack buffer is bound.
+    GLuint buffer = m_captureBuffers[m_capturedFrames % kCaptureBufferCount];
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer);
+    glReadPixels(0, 0, m_captureWidth, m_captureHeight, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    ++m_capturedFrames;
+
+    // Write the oldest frame before its buffer gets reused, which gives the
+    // GPU kCaptureBufferCount - 1 frames to finish the transfer.
+    if (m_capturedFrames - m_writtenFrames >= kCaptureBufferCount) {
+        writeCapturedFrame(m_writtenFrames++);
+    }
+}
+
+void TerrainVisualizer3D::writeCapturedFrame(uint64_t frame) {
+    GLsizeiptr size = static_cast<GLsizeiptr>(m_captureWidth) * m_captureHeight * 4;
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, m_captureBuffers[frame % kCaptureBufferCount]);
+    const unsigned char* pixels = static_cast<const unsigned char*>(glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size, GL_MAP_READ_BIT));
+    if (!pixels) {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        throw std::runtime_error("Failed to map frame capture buffer");
+    }
+
+    char name[32];
+    std::snprintf(name, sizeof(name), "_%06llu.ppm", static_cast<unsigned long long>(frame));
+    std::string path = m_capturePrefix + name;
+    std::ofstream file(path, std::ios::binary);
+    file << "P6\n" << m_captureWidth << " " << m_captureHeight << "\n255\n";
+
+    // GL rows start at the bottom, PPM rows at the top
+    std::vector<unsigned char> row(m_captureWidth * 3);
+    for (int y = m_captureHeight - 1; y >= 0; --y) {
+        const unsigned char* source = pixels + static_cast<size_t>(y) * m_captureWidth * 4;
+        for (int x = 0; x < m_captureWidth; ++x) {
+            row[x * 3] = source[x * 4];
+            row[x * 3 + 1] = source[x * 4 + 1];
+            row[x * 3 + 2] = source[x * 4 + 2];
+        }
+        file.write(reinterpret_cast<const char*>(row.data()), row.size());
+    }
+
+    glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    if (!file) {
+        throw std::runtime_error("Failed writing " + path);
+    }
+}
+
+GLuint TerrainVisualizer3D::createShaderProgram(const char* vertexSource, const char* fragmentSource) {
     GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertexShader, 1, &vertexShaderSource, NULL);
+    glShaderSource(vertexShader, 1, &vertexSource, NULL);
     glCompileShader(vertexShader);
 
     GLuint fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragmentShader, 1, &fragmentShaderSource, NULL);
+    glShaderSource(fragmentShader, 1, &fragmentSource, NULL);
     glCompileShader(fragmentShader);
 
-    m_shaderProgram = glCreateProgram();
-    glAttachShader(m_shaderProgram, vertexShader);
-    glAttachShader(m_shaderProgram, fragmentShader);
-    glLinkProgram(m_shaderProgram);
+    GLuint program = glCreateProgram();
+    glAttachShader(program, vertexShader);
+    glAttachShader(program, fragmentShader);
+    glLinkProgram(program);
 
     glDeleteShader(vertexShader);
     glDeleteShader(fragmentShader);
+    return program;
+}
+
+void TerrainVisualizer3D::setupShaders() {
+    m_shaderProgram = createShaderProgram(vertexShaderSource, fragmentShaderSource);
+    m_heightShaderProgram = createShaderProgram(heightVertexShaderSource, fragmentShaderSource);
 }
 
 void TerrainVisualizer3D::setupBuffers() {
     glGenVertexArrays(1, &m_VAO);
     glGenBuffers(1, &m_VBO);
     glGenBuffers(1, &m_EBO);
+
+    glGenVertexArrays(1, &m_gridVAO);
+    glGenBuffers(1, &m_gridVBO);
+    glGenBuffers(1, &m_gridEBO);
+    glGenTextures(1, &m_heightTexture);
+
+    setupColorRamp();
 }
 
-void TerrainVisualizer3D::updateBuffers(const Terrain& terrain, float erosionStage) {
-    m_vertices.clear();
-    m_indices.clear();
+void TerrainVisualizer3D::setupColorRamp() {
+    // Rows are erosion stages, columns heights
+    std::vector<GLfloat> ramp(kColorRampSize * kColorRampStages * 3);
+    for (int stage = 0; stage < kColorRampStages; ++stage) {
+        for (int i = 0; i < kColorRampSize; ++i) {
+            glm::vec3 color = getColorForHeight(static_cast<float>(i) / (kColorRampSize - 1),
+                                                static_cast<float>(stage) / (kColorRampStages - 1));
+            GLfloat* texel = &ramp[(stage * kColorRampSize + i) * 3];
+            texel[0] = color.r;
+            texel[1] = color.g;
+            texel[2] = color.b;
+        }
+    }
+
+    glGenTextures(1, &m_colorRampTexture);
+    glBindTexture(GL_TEXTURE_2D, m_colorRampTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, kColorRampSize, kColorRampStages, 0, GL_RGB, GL_FLOAT, ramp.data());
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void TerrainVisualizer3D::setRenderMode(RenderMode mode) {
+    m_renderMode = mode;
+}
+
+void TerrainVisualizer3D::setupGrid(int width, int height) {
+    // One vertex per cell, two triangles between each 2x2 group of cells
+    std::vector<GLfloat> cells;
+    cells.reserve(static_cast<size_t>(width) * height * 2);
+    for (int z = 0; z < height; ++z) {
+        for (int x = 0; x < width; ++x) {
+            cells.push_back(static_cast<GLfloat>(x));
+            cells.push_back(static_cast<GLfloat>(z));
+        }
+    }
+
+    std::vector<GLuint> indices;
+    indices.reserve(static_cast<size_t>(std::max(width - 1, 0)) * std::max(height - 1, 0) * 6);
+    for (int z = 0; z + 1 < height; ++z) {
+        for (int x = 0; x + 1 < width; ++x) {
+            GLuint topLeft = z * width + x;
+            GLuint bottomLeft = topLeft + width;
+            indices.insert(indices.end(), {topLeft, bottomLeft, topLeft + 1, topLeft + 1, bottomLeft, bottomLeft + 1});
+        }
+    }
+    m_gridIndexCount = indices.size();
+
+    glBindVertexArray(m_gridVAO);
+
+    glBindBuffer(GL_ARRAY_BUFFER, m_gridVBO);
+    glBufferData(GL_ARRAY_BUFFER, cells.size() * sizeof(GLfloat), cells.data(), GL_STATIC_DRAW);
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_gridEBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
+
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(GLfloat), (void*)0);
+    glEnableVertexAttribArray(0);
+
+    glBindVertexArray(0);
+
+    glBindTexture(GL_TEXTURE_2D, m_heightTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, width, height, 0, GL_RED, GL_FLOAT, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    m_gridWidth = width;
+    m_gridHeight = height;
+}
+
+void TerrainVisualizer3D::updateHeightTexture(const Terrain& terrain) {
+    if (m_gridWidth != m_terrainWidth || m_gridHeight != m_terrainHeight) {
+        setupGrid(m_terrainWidth, m_terrainHeight);
+    }
+
+    // The only per-frame upload in this mode: one float per cell
+    m_heightUpload.resize(static_cast<size_t>(m_terrainWidth) * m_terrainHeight);
+    for (int z = 0; z < m_terrainHeight; ++z) {
+        for (int x = 0; x < m_terrainWidth; ++x) {
+            m_heightUpload[z * m_terrainWidth + x] = terrain.getHeight(x, z);
+        }
+    }
 
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glBindTexture(GL_TEXTURE_2D, m_heightTexture);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, m_terrainWidth, m_terrainHeight, GL_RED, GL_FLOAT, m_heightUpload.data());
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void TerrainVisualizer3D::updateBuffers(const Terrain& terrain, float erosionStage) {
     m_terrainWidth = terrain.getWidth();
     m_terrainHeight = terrain.getHeight();
+    m_erosionStage = erosionStage;
 
     // Set camera position at one edge of the terrain
     m_cameraPos = glm::vec3(-10.0f, m_terrainHeight / 2.0f, m_terrainHeight / 2.0f);
     m_cameraTarget = glm::vec3(m_terrainWidth / 2.0f, 0.0f, m_terrainHeight / 2.0f);
 
+    if (m_renderMode == RenderMode::HeightTexture) {
+        updateHeightTexture(terrain);
+        return;
+    }
+
+    m_vertices.clear();
+    m_indices.clear();
+
     for (int z = 0; z < m_terrainHeight; ++z) {
         for (int x = 0; x < m_terrainWidth; ++x) {
-            float y = terrain.getHeight(x, z) * 20; // Amplify height for better visibility
+            float y = terrain.getHeight(x, z) * kHeightScale; // Amplify height for better visibility
             glm::vec3 color = getColorForHeight(terrain.getHeight(x, z), erosionStage);
             addCube(x, y, z, color);
         }
@@ -157,7 +545,8 @@ void TerrainVisualizer3D::drawTerrain() {
         glClearColor(0.529f, 0.808f, 0.922f, 1.0f); // Sky blue
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-    glUseProgram(m_shaderProgram);
+    GLuint program = m_renderMode == RenderMode::HeightTexture ? m_heightShaderProgram : m_shaderProgram;
+    glUseProgram(program);
 
     // Create view matrix
     glm::mat4 view = glm::lookAt(m_cameraPos, m_cameraTarget, glm::vec3(0.0f, 1.0f, 0.0f));
@@ -165,28 +554,46 @@ void TerrainVisualizer3D::drawTerrain() {
     glm::mat4 projection = glm::perspective(glm::radians(45.0f), 
         static_cast<float>(m_windowWidth) / m_windowHeight, 0.1f, 1000.0f);
 
-    GLuint viewLoc = glGetUniformLocation(m_shaderProgram, "view");
+    GLuint viewLoc = glGetUniformLocation(program, "view");
     glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(view));
 
-    GLuint projectionLoc = glGetUniformLocation(m_shaderProgram, "projection");
+    GLuint projectionLoc = glGetUniformLocation(program, "projection");
     glUniformMatrix4fv(projectionLoc, 1, GL_FALSE, glm::value_ptr(projection));
 
     glm::mat4 model = glm::mat4(1.0f);
-    GLuint modelLoc = glGetUniformLocation(m_shaderProgram, "model");
+    GLuint modelLoc = glGetUniformLocation(program, "model");
     glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
 
     glm::vec3 lightPos(m_terrainWidth / 2.0f, m_terrainHeight * 2.0f, m_terrainHeight / 2.0f);
-    GLuint lightPosLoc = glGetUniformLocation(m_shaderProgram, "lightPos");
+    GLuint lightPosLoc = glGetUniformLocation(program, "lightPos");
     glUniform3fv(lightPosLoc, 1, glm::value_ptr(lightPos));
 
-    GLuint viewPosLoc = glGetUniformLocation(m_shaderProgram, "viewPos");
+    GLuint viewPosLoc = glGetUniformLocation(program, "viewPos");
     glUniform3fv(viewPosLoc, 1, glm::value_ptr(m_cameraPos));
 
-    glBindVertexArray(m_VAO);
-    glDrawElements(GL_TRIANGLES, m_indices.size(), GL_UNSIGNED_INT, 0);
-    glBindVertexArray(0);
+    if (m_renderMode == RenderMode::HeightTexture) {
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, m_heightTexture);
+        glUniform1i(glGetUniformLocation(program, "heightMap"), 0);
 
-    glfwSwapBuffers(m_window);
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, m_colorRampTexture);
+        glUniform1i(glGetUniformLocation(program, "colorRamp"), 1);
+
+        glUniform1f(glGetUniformLocation(program, "heightScale"), kHeightScale);
+        glUniform1f(glGetUniformLocation(program, "erosionStage"), m_erosionStage);
+
+        glBindVertexArray(m_gridVAO);
+        glDrawElements(GL_TRIANGLES, m_gridIndexCount, GL_UNSIGNED_INT, 0);
+        glBindVertexArray(0);
+        glActiveTexture(GL_TEXTURE0);
+    } else {
+        glBindVertexArray(m_VAO);
+        glDrawElements(GL_TRIANGLES, m_indices.size(), GL_UNSIGNED_INT, 0);
+        glBindVertexArray(0);
+    }
+
+    presentFrame();
 }
 
 glm::vec3 TerrainVisualizer3D::getColorForHeight(float height, float erosionStage) {
@@ -273,6 +680,12 @@ void TerrainVisualizer3D::addCube(float x, float y, float z, const glm::vec3& co
 
 void TerrainVisualizer3D::visualize(const Terrain& terrain) {
     updateBuffers(terrain, 0.0f);
+
+    if (m_backend == RenderBackend::Offscreen) {
+        drawTerrain();
+        flushFrameCapture();
+        return;
+    }
     
     while (!glfwWindowShouldClose(m_window)) {
         drawTerrain();
@@ -281,6 +694,17 @@ void TerrainVisualizer3D::visualize(const Terrain& terrain) {
 }
 
 void TerrainVisualizer3D::animateErosion(Terrain& terrain, std::function<void(Terrain&)> erodeStep, int totalSteps, int fps) {
+    if (m_backend == RenderBackend::Offscreen) {
+        // Nothing to pace against, so render as fast as erosion allows
+        for (int step = 0; step < totalSteps; ++step) {
+            erodeStep(terrain);
+            updateBuffers(terrain, static_cast<float>(step) / totalSteps);
+            drawTerrain();
+        }
+        flushFrameCapture();
+        return;
+    }
+
     int delayMs = 1000 / fps;
 
     for (int step = 0; step < totalSteps; ++step) {
@@ -305,6 +729,9 @@ void TerrainVisualizer3D::animateErosion(Terrain& terrain, std::function<void(Te
         }
     }
 
+    // Only the animated steps are captured, not the idle frames below
+    setFrameCapture(std::string());
+
     while (!glfwWindowShouldClose(m_window)) {
         drawTerrain();
         glfwPollEvents();
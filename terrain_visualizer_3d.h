@@ -6,37 +6,103 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
+#ifdef TERRAIN_ENABLE_EGL
+#include <EGL/egl.h>
+#endif
 #include "terrain.h"
 #include <functional>
+#include <string>
 #include <vector>
 
+enum class RenderBackend {
+    Window,     // Visible GLFW window, presented with glfwSwapBuffers
+    Offscreen   // Surfaceless EGL context rendering into an FBO, no display or GPU needed
+};
+
+enum class RenderMode {
+    Cubes,          // One coloured cube per cell, rebuilt on the CPU every frame
+    HeightTexture   // Static grid displaced in the vertex shader; uploads 4 bytes per cell per frame
+};
+
 class TerrainVisualizer3D {
 public:
-    TerrainVisualizer3D(int windowWidth, int windowHeight);
+    // Offscreen needs a build with TERRAIN_ENABLE_EGL; without it the
+    // constructor throws.
+    TerrainVisualizer3D(int windowWidth, int windowHeight, RenderBackend backend = RenderBackend::Window);
     ~TerrainVisualizer3D();
 
+    // Offscreen: renders and captures a single frame.
     void visualize(const Terrain& terrain);
+    // Offscreen: renders every step back to back, ignoring fps.
     void animateErosion(Terrain& terrain, std::function<void(Terrain&)> erodeStep, int totalSteps, int fps);
 
+    // Writes every drawn frame to <pathPrefix>_NNNNNN.ppm. Frames are read back
+    // through a ring of pixel-buffer objects and written two frames later, so
+    // the readback never stalls the frame being rendered.
+    void setFrameCapture(const std::string& pathPrefix);
+    // Writes the frames still waiting in the readback ring.
+    void flushFrameCapture();
+
+    // Takes effect from the next updateBuffers call (i.e. the next erosion step).
+    void setRenderMode(RenderMode mode);
+
 private:
+    static const int kCaptureBufferCount = 3;
+
+    RenderBackend m_backend;
     GLFWwindow* m_window;
     int m_windowWidth;
     int m_windowHeight;
 
+#ifdef TERRAIN_ENABLE_EGL
+    EGLDisplay m_eglDisplay;
+    EGLContext m_eglContext;
+#endif
+    GLuint m_framebuffer;
+    GLuint m_colorRenderbuffer;
+    GLuint m_depthRenderbuffer;
+
+    std::string m_capturePrefix;
+    GLuint m_captureBuffers[kCaptureBufferCount];
+    int m_captureWidth;
+    int m_captureHeight;
+    uint64_t m_capturedFrames;  // Frames whose readback has been issued
+    uint64_t m_writtenFrames;   // Frames written to disk
+
     std::vector<GLfloat> m_vertices;
     std::vector<GLuint> m_indices;
     GLuint m_VBO, m_VAO, m_EBO;
     GLuint m_shaderProgram;
 
+    RenderMode m_renderMode;
+    GLuint m_heightShaderProgram;
+    GLuint m_gridVAO, m_gridVBO, m_gridEBO;
+    GLsizei m_gridIndexCount;
+    int m_gridWidth;
+    int m_gridHeight;
+    GLuint m_heightTexture;
+    GLuint m_colorRampTexture;
+    std::vector<GLfloat> m_heightUpload;
+    float m_erosionStage;
+
     glm::vec3 m_cameraPos;
     glm::vec3 m_cameraTarget;
     int m_terrainWidth;
     int m_terrainHeight;
 
     void initOpenGL();
+    void initWindow();
+    void initOffscreen();
     void cleanupOpenGL();
+    void presentFrame();
+    void captureFrame();
+    void writeCapturedFrame(uint64_t frame);
     void setupShaders();
     void setupBuffers();
+    GLuint createShaderProgram(const char* vertexSource, const char* fragmentSource);
+    void setupColorRamp();
+    void setupGrid(int width, int height);
+    void updateHeightTexture(const Terrain& terrain);
     void updateBuffers(const Terrain& terrain, float erosionStage);
     void drawTerrain();
     glm::vec3 getColorForHeight(float height, float erosionStage);
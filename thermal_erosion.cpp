@@ -0,0 +1,261 @@
+#include "thermal_erosion.h"
+#include <algorithm>
+#include <barrier>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+namespace {
+    // max(d, 0) without a branch. GCC will not if-convert std::max here: it
+    // sinks the following additions into the branches, and with trapping
+    // math it may not speculate them back out, so the loops stay scalar. The
+    // result is bit-identical to std::max.
+    inline float positivePart(float d) {
+        return 0.5f * (d + std::fabs(d));
+    }
+
+    // Fraction of the excess over each neighbour that leaves the cell
+    inline float outflowScale(float h, float left, float right, float up, float down, float talus, float rate) {
+        float excessLeft = positivePart(h - left - talus);
+        float excessRight = positivePart(h - right - talus);
+        float excessUp = positivePart(h - up - talus);
+        float excessDown = positivePart(h - down - talus);
+        float total = excessLeft + excessRight + excessUp + excessDown;
+        float largest = std::max(std::max(excessLeft, excessRight), std::max(excessUp, excessDown));
+        return rate * largest / std::max(total, 1e-30f);
+    }
+
+    // New height of a cell after one exchange with its neighbours. The
+    // diagnostics calls compile away entirely for NoDiagnostics.
+    template <typename Diagnostics>
+    inline float settledHeight(Diagnostics& diagnostics, uint32_t x, uint32_t y, float h, float scale,
+                               float left, float right, float up, float down,
+                               float scaleLeft, float scaleRight, float scaleUp, float scaleDown, float talus) {
+        float outflow = scale * (positivePart(h - left - talus) + positivePart(h - right - talus) +
+                                 positivePart(h - up - talus) + positivePart(h - down - talus));
+        float inflow = scaleLeft * positivePart(left - h - talus) + scaleRight * positivePart(right - h - talus) +
+                       scaleUp * positivePart(up - h - talus) + scaleDown * positivePart(down - h - talus);
+        if (outflow > 0.0f) {
+            diagnostics.visit(x, y);
+            diagnostics.erode(x, y, outflow);
+        }
+        if (inflow > 0.0f) {
+            diagnostics.deposit(x, y, inflow);
+        }
+        return h - outflow + inflow;
+    }
+
+    // Forwards to another policy and moves the same material through the
+    // layer stack. settledHeight reports a cell's outflow before its inflow,
+    // so what slides off comes from the old surface and what arrives lands
+    // on top as sediment.
+    template <typename Diagnostics>
+    class LayerTracking {
+    public:
+        LayerTracking(MaterialLayers& layers, Diagnostics& inner) : m_layers(layers), m_inner(inner) {}
+
+        void visit(uint32_t x, uint32_t y) { m_inner.visit(x, y); }
+        void erode(uint32_t x, uint32_t y, float amount) {
+            m_layers.erode(x, y, amount);
+            m_inner.erode(x, y, amount);
+        }
+        void deposit(uint32_t x, uint32_t y, float amount) {
+            m_layers.deposit(x, y, amount);
+            m_inner.deposit(x, y, amount);
+        }
+
+    private:
+        MaterialLayers& m_layers;
+        Diagnostics& m_inner;
+    };
+}
+
+ThermalErosion::ThermalErosion(float talus, float rate, uint32_t threadCount)
+    : m_talus(talus), m_rate(rate), m_threadCount(std::max(threadCount, 1u)), m_lastCellsPerSecond(0.0), m_layers(nullptr) {}
+
+std::vector<std::vector<float>> ThermalErosion::erode(const std::vector<std::vector<float>>& inputHeightMap, uint32_t iterations) {
+    std::vector<std::vector<float>> heightMap = inputHeightMap;
+    erodeInPlace(heightMap, iterations);
+    return heightMap;
+}
+
+double ThermalErosion::erodeInPlace(std::vector<std::vector<float>>& heightMap, uint32_t iterations) {
+    NoDiagnostics diagnostics;
+    return erodeNested(heightMap, iterations, diagnostics);
+}
+
+double ThermalErosion::erodeWithDiagnostics(std::vector<std::vector<float>>& heightMap, uint32_t iterations, ErosionDiagnostics& diagnostics) {
+    diagnostics.resize(heightMap[0].size(), heightMap.size());
+    CellDiagnostics record(diagnostics);
+    return erodeNested(heightMap, iterations, record);
+}
+
+void ThermalErosion::erodeFlat(float* heights, uint32_t width, uint32_t height, uint32_t iterations) {
+    NoDiagnostics diagnostics;
+    erodeBands(heights, width, height, iterations, diagnostics);
+}
+
+void ThermalErosion::erodeFlat(float* heights, uint32_t width, uint32_t height, uint32_t iterations, ErosionDiagnostics& diagnostics) {
+    diagnostics.resize(width, height);
+    CellDiagnostics record(diagnostics);
+    erodeBands(heights, width, height, iterations, record);
+}
+
+template <typename Diagnostics>
+double ThermalErosion::erodeNested(std::vector<std::vector<float>>& heightMap, uint32_t iterations, Diagnostics& diagnostics) {
+    uint32_t width = heightMap[0].size();
+    uint32_t height = heightMap.size();
+
+    m_flat.resize(static_cast<size_t>(width) * height);
+    for (uint32_t y = 0; y < height; ++y) {
+        std::memcpy(&m_flat[static_cast<size_t>(y) * width], heightMap[y].data(), width * sizeof(float));
+    }
+
+    erodeBands(m_flat.data(), width, height, iterations, diagnostics);
+
+    double change = 0.0;
+    for (uint32_t y = 0; y < height; ++y) {
+        const float* row = &m_flat[static_cast<size_t>(y) * width];
+        for (uint32_t x = 0; x < width; ++x) {
+            change += std::abs(row[x] - heightMap[y][x]);
+            heightMap[y][x] = row[x];
+        }
+    }
+    return change;
+}
+
+template <typename Diagnostics>
+void ThermalErosion::erodeBands(float* heights, uint32_t width, uint32_t height, uint32_t iterations, Diagnostics& diagnostics) {
+    if (m_layers) {
+        LayerTracking<Diagnostics> tracking(*m_layers, diagnostics);
+        runBands(heights, width, height, iterations, tracking);
+    } else {
+        runBands(heights, width, height, iterations, diagnostics);
+    }
+}
+
+// Every band records diagnostics and updates layers only for its own rows, so
+// threads share one output without atomics and without per-thread copies to
+// reduce.
+template <typename Diagnostics>
+void ThermalErosion::runBands(float* heights, uint32_t width, uint32_t height, uint32_t iterations, Diagnostics& diagnostics) {
+    auto start = std::chrono::steady_clock::now();
+    size_t cellCount = static_cast<size_t>(width) * height;
+    m_next.resize(cellCount);
+    m_scale.resize(cellCount);
+
+    // Bands of at least a few rows, so barrier cost stays small next to the work
+    uint32_t threadCount = std::clamp(m_threadCount, 1u, std::max(height / 8, 1u));
+    std::barrier sync(threadCount);
+    float* buffers[2] = {heights, m_next.data()};
+
+    auto worker = [&](uint32_t band) {
+        uint32_t y0 = static_cast<uint64_t>(height) * band / threadCount;
+        uint32_t y1 = static_cast<uint64_t>(height) * (band + 1) / threadCount;
+        for (uint32_t i = 0; i < iterations; ++i) {
+            const float* source = buffers[i & 1];
+            float* target = buffers[(i + 1) & 1];
+            computeScales(source, width, height, y0, y1);
+            if (m_layers) {
+                scaleByErodibility(width, y0, y1);
+            }
+            sync.arrive_and_wait();
+            applyFlow(source, target, width, height, y0, y1, diagnostics);
+            sync.arrive_and_wait();
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (uint32_t band = 1; band < threadCount; ++band) {
+        threads.emplace_back(worker, band);
+    }
+    worker(0);
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    if (iterations & 1) {
+        std::memcpy(heights, m_next.data(), cellCount * sizeof(float));
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    m_lastCellsPerSecond = seconds > 0.0 ? static_cast<double>(cellCount) * iterations / seconds : 0.0;
+}
+
+// Neighbours outside the map are clamped to the cell itself, which has no
+// excess over itself, so the border needs no special cases beyond indexing.
+void ThermalErosion::computeScales(const float* heights, uint32_t width, uint32_t height, uint32_t y0, uint32_t y1) {
+    const float talus = m_talus;
+    const float rate = m_rate;
+
+    for (uint32_t y = y0; y < y1; ++y) {
+        const float* row = heights + static_cast<size_t>(y) * width;
+        const float* up = y > 0 ? row - width : row;
+        const float* down = y + 1 < height ? row + width : row;
+        float* scale = m_scale.data() + static_cast<size_t>(y) * width;
+
+        if (width == 1) {
+            scale[0] = outflowScale(row[0], row[0], row[0], up[0], down[0], talus, rate);
+            continue;
+        }
+
+        scale[0] = outflowScale(row[0], row[0], row[1], up[0], down[0], talus, rate);
+        for (uint32_t x = 1; x + 1 < width; ++x) {
+            scale[x] = outflowScale(row[x], row[x - 1], row[x + 1], up[x], down[x], talus, rate);
+        }
+        uint32_t last = width - 1;
+        scale[last] = outflowScale(row[last], row[last - 1], row[last], up[last], down[last], talus, rate);
+    }
+}
+
+// A separate pass, so the unlayered computeScales loop stays vectorisable.
+// Soft layers may move faster than m_rate, but never faster than the stable
+// rate of 0.5 unless m_rate already exceeds it; a hardness of 1 matches the
+// unlayered result exactly.
+void ThermalErosion::scaleByErodibility(uint32_t width, uint32_t y0, uint32_t y1) {
+    float maxErodibility = m_rate > 0.0f ? std::max(m_rate, 0.5f) / m_rate : 1.0f;
+
+    for (uint32_t y = y0; y < y1; ++y) {
+        float* scale = m_scale.data() + static_cast<size_t>(y) * width;
+        for (uint32_t x = 0; x < width; ++x) {
+            scale[x] *= std::min(m_layers->getErodibility(x, y), maxErodibility);
+        }
+    }
+}
+
+template <typename Diagnostics>
+void ThermalErosion::applyFlow(const float* heights, float* next, uint32_t width, uint32_t height, uint32_t y0, uint32_t y1,
+                               Diagnostics& diagnostics) {
+    const float talus = m_talus;
+    const float* scales = m_scale.data();
+
+    for (uint32_t y = y0; y < y1; ++y) {
+        size_t rowOffset = static_cast<size_t>(y) * width;
+        size_t upOffset = y > 0 ? rowOffset - width : rowOffset;
+        size_t downOffset = y + 1 < height ? rowOffset + width : rowOffset;
+
+        const float* row = heights + rowOffset;
+        const float* up = heights + upOffset;
+        const float* down = heights + downOffset;
+        const float* scale = scales + rowOffset;
+        const float* scaleUp = scales + upOffset;
+        const float* scaleDown = scales + downOffset;
+        float* out = next + rowOffset;
+
+        if (width == 1) {
+            out[0] = settledHeight(diagnostics, 0, y, row[0], scale[0], row[0], row[0], up[0], down[0],
+                                   scale[0], scale[0], scaleUp[0], scaleDown[0], talus);
+            continue;
+        }
+
+        out[0] = settledHeight(diagnostics, 0, y, row[0], scale[0], row[0], row[1], up[0], down[0],
+                               scale[0], scale[1], scaleUp[0], scaleDown[0], talus);
+        for (uint32_t x = 1; x + 1 < width; ++x) {
+            out[x] = settledHeight(diagnostics, x, y, row[x], scale[x], row[x - 1], row[x + 1], up[x], down[x],
+                                   scale[x - 1], scale[x + 1], scaleUp[x], scaleDown[x], talus);
+        }
+        uint32_t last = width - 1;
+        out[last] = settledHeight(diagnostics, last, y, row[last], scale[last], row[last - 1], row[last], up[last], down[last],
+                                  scale[last - 1], scale[last], scaleUp[last], scaleDown[last], talus);
+    }
+}
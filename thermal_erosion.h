@@ -0,0 +1,66 @@
+#ifndef THERMAL_EROSION_H
+#define THERMAL_EROSION_H
+
+#include <vector>
+#include <cstdint>
+#include <thread>
+#include "erosion_engine.h"
+#include "erosion_diagnostics.h"
+#include "material_layers.h"
+
+// Thermal (talus) erosion as a cellular automaton: wherever a cell is more
+// than `talus` above a 4-neighbour, a fraction of the excess slides down,
+// split between the lower neighbours in proportion to their excess.
+//
+// Each iteration is race-free by construction: a first pass writes only each
+// cell's outflow scale, a second pass gathers every cell's new height from
+// its own and its neighbours' scales into a second buffer. Rows are split
+// into bands across threads, and the inner loops are branch-free over
+// contiguous rows so the compiler vectorises them (at -O3, which the default
+// Release build uses).
+class ThermalErosion : public ErosionEngine {
+public:
+    // rate is the fraction of the largest excess moved per iteration; values
+    // up to 0.5 are stable.
+    ThermalErosion(float talus = 0.01f, float rate = 0.5f, uint32_t threadCount = std::thread::hardware_concurrency());
+
+    std::vector<std::vector<float>> erode(const std::vector<std::vector<float>>& heightMap, uint32_t iterations) override;
+    double erodeInPlace(std::vector<std::vector<float>>& heightMap, uint32_t iterations) override;
+    // A visit is an iteration in which material slid off the cell.
+    double erodeWithDiagnostics(std::vector<std::vector<float>>& heightMap, uint32_t iterations, ErosionDiagnostics& diagnostics) override;
+    // Scales each cell's outflow by the erodibility of its exposed layer
+    // (capped at the stable rate), removes what slides off from the top down
+    // and deposits what arrives into layer 0.
+    void setMaterialLayers(MaterialLayers* layers) override { m_layers = layers; }
+
+    // Row-major in-place variants for callers that already hold flat heights.
+    void erodeFlat(float* heights, uint32_t width, uint32_t height, uint32_t iterations);
+    void erodeFlat(float* heights, uint32_t width, uint32_t height, uint32_t iterations, ErosionDiagnostics& diagnostics);
+
+    // Throughput of the last call, in cell updates per second.
+    double getLastCellsPerSecond() const { return m_lastCellsPerSecond; }
+
+private:
+    float m_talus;
+    float m_rate;
+    uint32_t m_threadCount;
+    double m_lastCellsPerSecond;
+    MaterialLayers* m_layers;
+
+    std::vector<float> m_flat;
+    std::vector<float> m_next;
+    std::vector<float> m_scale;
+
+    template <typename Diagnostics>
+    double erodeNested(std::vector<std::vector<float>>& heightMap, uint32_t iterations, Diagnostics& diagnostics);
+    template <typename Diagnostics>
+    void erodeBands(float* heights, uint32_t width, uint32_t height, uint32_t iterations, Diagnostics& diagnostics);
+    template <typename Diagnostics>
+    void runBands(float* heights, uint32_t width, uint32_t height, uint32_t iterations, Diagnostics& diagnostics);
+    void computeScales(const float* heights, uint32_t width, uint32_t height, uint32_t y0, uint32_t y1);
+    void scaleByErodibility(uint32_t width, uint32_t y0, uint32_t y1);
+    template <typename Diagnostics>
+    void applyFlow(const float* heights, float* next, uint32_t width, uint32_t height, uint32_t y0, uint32_t y1, Diagnostics& diagnostics);
+};
+
+#endif // THERMAL_EROSION_H
@@ -0,0 +1,159 @@
+#include "tiled_height_store.h"
+#include <algorithm>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+    // Largest page size in common use (Apple silicon); 4 KB pages divide it
+    const size_t kTileAlignment = 16384;
+    const uint32_t kNoTile = std::numeric_limits<uint32_t>::max();
+}
+
+TiledHeightStore::TiledHeightStore(const std::string& path, uint32_t width, uint32_t height, uint32_t tileSize, uint32_t maxResidentTiles)
+    : m_width(width), m_height(height), m_tileSize(tileSize), m_tileShift(0), m_tileMask(tileSize - 1),
+      m_maxResidentTiles(std::max(maxResidentTiles, 16u)), m_fd(-1), m_lastTile(kNoTile), m_lastEntry(nullptr), m_tileLoads(0) {
+    if (tileSize == 0 || (tileSize & (tileSize - 1)) != 0) {
+        throw std::runtime_error("Tile size must be a power of two");
+    }
+    while ((1u << m_tileShift) < tileSize) {
+        ++m_tileShift;
+    }
+
+    m_tilesX = (width + tileSize - 1) / tileSize;
+    m_tilesY = (height + tileSize - 1) / tileSize;
+    size_t cellBytes = static_cast<size_t>(tileSize) * tileSize * sizeof(float);
+    m_tileBytes = (cellBytes + kTileAlignment - 1) / kTileAlignment * kTileAlignment;
+
+    m_fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (m_fd < 0) {
+        throw std::runtime_error("Could not open " + path);
+    }
+
+    off_t fileSize = static_cast<off_t>(m_tileBytes) * m_tilesX * m_tilesY;
+    struct stat info;
+    if (::fstat(m_fd, &info) != 0 || (info.st_size != fileSize && ::ftruncate(m_fd, fileSize) != 0)) {
+        ::close(m_fd);
+        throw std::runtime_error("Could not size " + path);
+    }
+}
+
+TiledHeightStore::~TiledHeightStore() {
+    for (auto& [tile, entry] : m_tiles) {
+        if (entry.dirty) {
+            ::msync(entry.data, m_tileBytes, MS_SYNC);
+        }
+        ::munmap(entry.data, m_tileBytes);
+    }
+    // Evicted tiles were only scheduled for write-back
+    ::fsync(m_fd);
+    ::close(m_fd);
+}
+
+TiledHeightStore::CachedTile& TiledHeightStore::acquire(uint32_t tile) const {
+    auto found = m_tiles.find(tile);
+    if (found != m_tiles.end()) {
+        m_lru.splice(m_lru.begin(), m_lru, found->second.lruPosition);
+    } else {
+        if (m_tiles.size() >= m_maxResidentTiles) {
+            evictOne();
+        }
+
+        off_t offset = static_cast<off_t>(m_tileBytes) * tile;
+        void* data = ::mmap(nullptr, m_tileBytes, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, offset);
+        if (data == MAP_FAILED) {
+            throw std::runtime_error("Could not map terrain tile");
+        }
+        // Fault the whole tile in at once instead of page by page
+        ::madvise(data, m_tileBytes, MADV_WILLNEED);
+        ++m_tileLoads;
+
+        m_lru.push_front(tile);
+        found = m_tiles.emplace(tile, CachedTile{static_cast<float*>(data), 0, false, m_lru.begin()}).first;
+    }
+
+    m_lastTile = tile;
+    m_lastEntry = &found->second;
+    return found->second;
+}
+
+void TiledHeightStore::evictOne() const {
+    for (auto it = m_lru.rbegin(); it != m_lru.rend(); ++it) {
+        auto found = m_tiles.find(*it);
+        if (found->second.pins == 0) {
+            unmap(found->first, found->second);
+            m_lru.erase(std::next(it).base());
+            m_tiles.erase(found);
+            return;
+        }
+    }
+    throw std::runtime_error("Every cached terrain tile is pinned");
+}
+
+void TiledHeightStore::unmap(uint32_t tile, CachedTile& entry) const {
+    // Start the write-back without waiting; the kernel finishes it later
+    if (entry.dirty) {
+        ::msync(entry.data, m_tileBytes, MS_ASYNC);
+    }
+    ::munmap(entry.data, m_tileBytes);
+    if (tile == m_lastTile) {
+        m_lastTile = kNoTile;
+        m_lastEntry = nullptr;
+    }
+}
+
+const float* TiledHeightStore::pinTile(uint32_t tileX, uint32_t tileY) {
+    CachedTile& entry = acquire(tileY * m_tilesX + tileX);
+    entry.pins++;
+    return entry.data;
+}
+
+float* TiledHeightStore::pinTileForWriting(uint32_t tileX, uint32_t tileY) {
+    CachedTile& entry = acquire(tileY * m_tilesX + tileX);
+    entry.pins++;
+    entry.dirty = true;
+    return entry.data;
+}
+
+void TiledHeightStore::unpinTile(uint32_t tileX, uint32_t tileY) {
+    auto found = m_tiles.find(tileY * m_tilesX + tileX);
+    if (found == m_tiles.end() || found->second.pins == 0) {
+        throw std::runtime_error("Unpinning a terrain tile that is not pinned");
+    }
+    found->second.pins--;
+}
+
+void TiledHeightStore::fill(const std::function<float(uint32_t x, uint32_t y)>& height) {
+    for (uint32_t tileY = 0; tileY < m_tilesY; ++tileY) {
+        for (uint32_t tileX = 0; tileX < m_tilesX; ++tileX) {
+            float* cells = pinTileForWriting(tileX, tileY);
+            uint32_t x0 = tileX * m_tileSize;
+            uint32_t y0 = tileY * m_tileSize;
+            uint32_t x1 = std::min(x0 + m_tileSize, m_width);
+            uint32_t y1 = std::min(y0 + m_tileSize, m_height);
+            for (uint32_t y = y0; y < y1; ++y) {
+                for (uint32_t x = x0; x < x1; ++x) {
+                    cells[(y - y0) * m_tileSize + (x - x0)] = height(x, y);
+                }
+            }
+            unpinTile(tileX, tileY);
+        }
+    }
+}
+
+void TiledHeightStore::flush() {
+    for (auto& [tile, entry] : m_tiles) {
+        if (entry.dirty) {
+            if (::msync(entry.data, m_tileBytes, MS_SYNC) != 0) {
+                throw std::runtime_error("Failed writing terrain tile");
+            }
+            entry.dirty = false;
+        }
+    }
+    // Evicted tiles were only scheduled for write-back
+    if (::fsync(m_fd) != 0) {
+        throw std::runtime_error("Failed writing terrain tile");
+    }
+}
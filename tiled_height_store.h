@@ -0,0 +1,104 @@
+#ifndef TILED_HEIGHT_STORE_H
+#define TILED_HEIGHT_STORE_H
+
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <list>
+#include <string>
+#include <unordered_map>
+
+// Height map kept in a file of square tiles, for maps that do not fit in
+// memory. Each tile is mapped on its own when first touched, and at most
+// maxResidentTiles stay mapped; the least recently used unpinned tile is
+// written back and unmapped to make room. Tiles are padded to a multiple of
+// 16 KB so every mapping is page aligned on both 4 KB and 16 KB page systems
+// (64 x 64 floats is exactly 16 KB).
+//
+// getWidth/getHeight/getHeight(x, y)/setHeight match Terrain, so code written
+// against that sampling API works on either. Not thread-safe: even reads can
+// map and unmap tiles.
+class TiledHeightStore {
+public:
+    // Opens path, creating it if needed. An existing file of the expected size
+    // keeps its contents, so a store can be reopened. tileSize must be a power
+    // of two.
+    TiledHeightStore(const std::string& path, uint32_t width, uint32_t height, uint32_t tileSize = 64, uint32_t maxResidentTiles = 1024);
+    ~TiledHeightStore();
+
+    TiledHeightStore(const TiledHeightStore&) = delete;
+    TiledHeightStore& operator=(const TiledHeightStore&) = delete;
+
+    uint32_t getWidth() const { return m_width; }
+    uint32_t getHeight() const { return m_height; }
+    uint32_t getTileSize() const { return m_tileSize; }
+    uint32_t getTilesX() const { return m_tilesX; }
+    uint32_t getTilesY() const { return m_tilesY; }
+
+    float getHeight(uint32_t x, uint32_t y) const {
+        const CachedTile& tile = lookup(x, y);
+        return tile.data[((y & m_tileMask) << m_tileShift) + (x & m_tileMask)];
+    }
+    void setHeight(uint32_t x, uint32_t y, float height) {
+        CachedTile& tile = lookup(x, y);
+        tile.dirty = true;
+        tile.data[((y & m_tileMask) << m_tileShift) + (x & m_tileMask)] = height;
+    }
+
+    // Keeps a tile mapped until the matching unpinTile and returns its
+    // tileSize x tileSize row-major cells. Pinning does not mark the tile
+    // modified, so writes must go through setHeight.
+    const float* pinTile(uint32_t tileX, uint32_t tileY);
+    // As pinTile, but the cells may be written directly. The tile is marked
+    // modified up front and written back even if nothing changed.
+    float* pinTileForWriting(uint32_t tileX, uint32_t tileY);
+    void unpinTile(uint32_t tileX, uint32_t tileY);
+
+    // Sets every cell, one tile at a time.
+    void fill(const std::function<float(uint32_t x, uint32_t y)>& height);
+    // Writes all modified tiles back to the file, including ones already
+    // evicted, and waits until they reach the disk.
+    void flush();
+
+    uint32_t getResidentTileCount() const { return static_cast<uint32_t>(m_tiles.size()); }
+    // Number of times a tile had to be mapped, i.e. cache misses.
+    uint64_t getTileLoads() const { return m_tileLoads; }
+
+private:
+    struct CachedTile {
+        float* data;
+        uint32_t pins;
+        bool dirty;
+        std::list<uint32_t>::iterator lruPosition;
+    };
+
+    uint32_t m_width;
+    uint32_t m_height;
+    uint32_t m_tileSize;
+    uint32_t m_tileShift;
+    uint32_t m_tileMask;
+    uint32_t m_tilesX;
+    uint32_t m_tilesY;
+    uint32_t m_maxResidentTiles;
+    size_t m_tileBytes;
+    int m_fd;
+
+    // Mapping tiles in and out does not change the heights, so the cache is
+    // mutable and getHeight stays const like Terrain's.
+    mutable std::unordered_map<uint32_t, CachedTile> m_tiles;
+    mutable std::list<uint32_t> m_lru;      // Most recently used first
+    mutable uint32_t m_lastTile;            // One-entry cache in front of m_tiles
+    mutable CachedTile* m_lastEntry;
+    mutable uint64_t m_tileLoads;
+
+    CachedTile& lookup(uint32_t x, uint32_t y) const {
+        uint32_t tile = (y >> m_tileShift) * m_tilesX + (x >> m_tileShift);
+        return tile == m_lastTile ? *m_lastEntry : acquire(tile);
+    }
+    CachedTile& acquire(uint32_t tile) const;
+    void evictOne() const;
+    void unmap(uint32_t tile, CachedTile& entry) const;
+};
+
+#endif // TILED_HEIGHT_STORE_H
@@ -0,0 +1,102 @@
+#include "work_stealing_pool.h"
+#include <algorithm>
+
+namespace {
+    thread_local const WorkStealingPool* t_currentPool = nullptr;
+    thread_local uint32_t t_workerIndex = 0;
+}
+
+WorkStealingPool::WorkStealingPool(uint32_t threadCount)
+    : m_pendingTasks(0), m_nextQueue(0), m_stopping(false) {
+    threadCount = std::max(threadCount, 1u);
+
+    for (uint32_t i = 0; i < threadCount; ++i) {
+        m_queues.push_back(std::make_unique<WorkerQueue>());
+    }
+    for (uint32_t i = 0; i < threadCount; ++i) {
+        m_threads.emplace_back(&WorkStealingPool::workerLoop, this, i);
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        m_stopping = true;
+    }
+    m_wakeUp.notify_all();
+
+    for (std::thread& thread : m_threads) {
+        thread.join();
+    }
+}
+
+void WorkStealingPool::submit(std::function<void()> task) {
+    uint32_t index;
+    if (t_currentPool == this) {
+        index = t_workerIndex;
+    } else {
+        index = m_nextQueue.fetch_add(1, std::memory_order_relaxed) % m_queues.size();
+    }
+
+    {
+        // Taking the sleep mutex orders the increment against a worker that is
+        // about to wait, so the wake-up cannot be lost. The count goes up
+        // before the task is visible, so a worker that pops it at once never
+        // takes the count below zero, and a sleeper can't see the new count
+        // until the task is there to take.
+        std::lock_guard<std::mutex> sleepLock(m_sleepMutex);
+        m_pendingTasks.fetch_add(1, std::memory_order_release);
+        std::lock_guard<std::mutex> queueLock(m_queues[index]->mutex);
+        m_queues[index]->tasks.push_back(std::move(task));
+    }
+    m_wakeUp.notify_one();
+}
+
+void WorkStealingPool::workerLoop(uint32_t index) {
+    t_currentPool = this;
+    t_workerIndex = index;
+
+    std::function<void()> task;
+    while (true) {
+        if (popLocal(index, task) || steal(index, task)) {
+            m_pendingTasks.fetch_sub(1, std::memory_order_acq_rel);
+            task();
+            task = nullptr;
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_sleepMutex);
+        m_wakeUp.wait(lock, [this] {
+            return m_stopping || m_pendingTasks.load(std::memory_order_acquire) > 0;
+        });
+        if (m_stopping && m_pendingTasks.load(std::memory_order_acquire) == 0) {
+            return;
+        }
+    }
+}
+
+bool WorkStealingPool::popLocal(uint32_t index, std::function<void()>& task) {
+    WorkerQueue& queue = *m_queues[index];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty()) {
+        return false;
+    }
+    task = std::move(queue.tasks.back());
+    queue.tasks.pop_back();
+    return true;
+}
+
+bool WorkStealingPool::steal(uint32_t thiefIndex, std::function<void()>& task) {
+    uint32_t queueCount = static_cast<uint32_t>(m_queues.size());
+    for (uint32_t offset = 1; offset < queueCount; ++offset) {
+        WorkerQueue& victim = *m_queues[(thiefIndex + offset) % queueCount];
+        std::unique_lock<std::mutex> lock(victim.mutex, std::try_to_lock);
+        if (!lock.owns_lock() || victim.tasks.empty()) {
+            continue;
+        }
+        task = std::move(victim.tasks.front());
+        victim.tasks.pop_front();
+        return true;
+    }
+    return false;
+}
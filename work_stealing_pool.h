@@ -0,0 +1,51 @@
+#ifndef WORK_STEALING_POOL_H
+#define WORK_STEALING_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed-size thread pool where every worker owns a task deque. Workers pop
+// their own newest task first (good cache locality for follow-up stages) and
+// steal the oldest task from other workers when they run dry.
+class WorkStealingPool {
+public:
+    explicit WorkStealingPool(uint32_t threadCount = std::thread::hardware_concurrency());
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    // Tasks submitted from a worker go to that worker's own deque, others are
+    // distributed round-robin.
+    void submit(std::function<void()> task);
+
+    uint32_t getThreadCount() const { return static_cast<uint32_t>(m_threads.size()); }
+
+private:
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    std::vector<std::unique_ptr<WorkerQueue>> m_queues;
+    std::vector<std::thread> m_threads;
+
+    std::mutex m_sleepMutex;
+    std::condition_variable m_wakeUp;
+    std::atomic<uint64_t> m_pendingTasks;
+    std::atomic<uint32_t> m_nextQueue;
+    bool m_stopping;
+
+    void workerLoop(uint32_t index);
+    bool popLocal(uint32_t index, std::function<void()>& task);
+    bool steal(uint32_t thiefIndex, std::function<void()>& task);
+};
+
+#endif // WORK_STEALING_POOL_H